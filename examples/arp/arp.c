@@ -15,6 +15,7 @@
 #include "arp_test.h"
 
 int spi_handle;
+int irq_fd;
 
 unsigned char follower_ip[IP_LEN];
 unsigned char coordinator_ip[IP_LEN];
@@ -234,20 +235,18 @@ int do_as_coordinator() {
 #endif
     printf("Success to send ARP request\n");
 
+    do {
 #ifdef FRAME_TIMESTAMP_ENABLE
-    ret = spi_receive_frame_with_timestamp((unsigned int)spi_handle, reply_packet, &received_length, &timestamp);
+        ret = spi_receive_frame_with_timestamp_wait((unsigned int)spi_handle, irq_fd, reply_packet, &received_length,
+                                                    &timestamp, RECEIVE_TIMEOUT_MS);
 #else
-    ret = spi_receive_frame((unsigned int)spi_handle, reply_packet, &received_length);
+        ret = spi_receive_frame_wait((unsigned int)spi_handle, irq_fd, reply_packet, &received_length,
+                                     RECEIVE_TIMEOUT_MS);
 #endif
-    while (ret != RET_SUCCESS) {
-        printf("Fail to receive ARP reply, the error code is %d\n", ret);
-        sleep(1);
-#ifdef FRAME_TIMESTAMP_ENABLE
-        ret = spi_receive_frame_with_timestamp((unsigned int)spi_handle, reply_packet, &received_length, &timestamp);
-#else
-        ret = spi_receive_frame((unsigned int)spi_handle, reply_packet, &received_length);
-#endif
-    }
+        if (ret != RET_SUCCESS) {
+            printf("Fail to receive ARP reply, the error code is %d\n", ret);
+        }
+    } while (ret != RET_SUCCESS);
 
 #if 0
     for(int id=0; id<received_length; id++) {
@@ -291,20 +290,17 @@ int do_as_follower() {
         return -1;
     }
 
+    do {
 #ifdef FRAME_TIMESTAMP_ENABLE
-    ret = spi_receive_frame_with_timestamp((unsigned int)spi_handle, buffer, &received_length, &timestamp);
+        ret = spi_receive_frame_with_timestamp_wait((unsigned int)spi_handle, irq_fd, buffer, &received_length,
+                                                    &timestamp, RECEIVE_TIMEOUT_MS);
 #else
-    ret = spi_receive_frame((unsigned int)spi_handle, buffer, &received_length);
+        ret = spi_receive_frame_wait((unsigned int)spi_handle, irq_fd, buffer, &received_length, RECEIVE_TIMEOUT_MS);
 #endif
-    while (ret != RET_SUCCESS) {
-        printf("Fail to receive ARP request, the error code is %d\n", ret);
-        sleep(1);
-#ifdef FRAME_TIMESTAMP_ENABLE
-        ret = spi_receive_frame_with_timestamp((unsigned int)spi_handle, buffer, &received_length, &timestamp);
-#else
-        ret = spi_receive_frame((unsigned int)spi_handle, buffer, &received_length);
-#endif
-    }
+        if (ret != RET_SUCCESS) {
+            printf("Fail to receive ARP request, the error code is %d\n", ret);
+        }
+    } while (ret != RET_SUCCESS);
 
 #ifdef FRAME_TIMESTAMP_ENABLE
     printf("Receive Time-Stamp:\n");
@@ -362,6 +358,13 @@ int main(int argc, char* argv[]) {
         return -RET_FAIL;
     }
 
+    irq_fd = spi_irq_open(LAN865X_IRQ_GPIO_CHIP, LAN865X_IRQ_GPIO_LINE);
+    if (irq_fd < 0) {
+        printf("Fail to open the MAC-PHY IRQ line, error code:%d\n", irq_fd);
+        spi_close((unsigned int)spi_handle);
+        return -RET_FAIL;
+    }
+
     sscanf(FOLLOWER_IP4, "%d.%d.%d.%d", &follower_ip[0], &follower_ip[1], &follower_ip[2], &follower_ip[3]);
     sscanf(COORDINATOR_IP4, "%d.%d.%d.%d", &coordinator_ip[0], &coordinator_ip[1], &coordinator_ip[2],
            &coordinator_ip[3]);
@@ -390,6 +393,7 @@ int main(int argc, char* argv[]) {
         printf("Invalid argument: %s\n Usage: %s -c|-f|-h\n", argv[optind], argv[0]);
     }
 
+    spi_irq_close(irq_fd);
     spi_close((unsigned int)spi_handle);
 
     return 0;
@@ -11,6 +11,8 @@
 
 #define MAX_PACKET_SIZE 2048
 
+#define RECEIVE_TIMEOUT_MS 1000
+
 #define ETH_ALEN 6
 #define ETH_HLEN 14
 #define ARP_HLEN 28
@@ -0,0 +1,567 @@
+#define _GNU_SOURCE
+
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/ethtool.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <linux/ptp_clock.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+/* Sends sequenced frames from one node to another and reports where the time goes, using the lan865x hardware
+ * timestamps:
+ *  - sender: SPI to wire, hardware TX timestamp minus software TX timestamp (taken when the frame goes to SPI)
+ *  - receiver: one-way wire latency, hardware RX timestamp minus the sender's hardware TX timestamp, which comes in a
+ *    follow-up frame. The PHCs of both nodes have to be synchronized, e.g. by ptp4l.
+ *  - receiver: wire to socket, recvmsg() return time minus hardware RX timestamp
+ * Software and hardware timestamps are compared through the PHC to system clock offset from PTP_SYS_OFFSET.
+ */
+
+#define ETH_P_HWTS 0x88B5 /* local experimental ethertype */
+#define HWTS_MAGIC 0x48575453
+
+#define MSG_DATA 1
+#define MSG_FOLLOW_UP 2
+
+#define DEFAULT_COUNT 1000
+#define DEFAULT_INTERVAL_US 10000
+#define DEFAULT_LENGTH 64
+#define MAX_FRAME_SIZE 1514
+
+#define TX_TIMESTAMP_TIMEOUT_MS 1000
+#define OFFSET_REFRESH_NS 1000000000LL
+#define OFFSET_SAMPLES 9
+#define RX_RING_SIZE 256
+
+#define HIST_BUCKETS 100000 /* 1 us each, up to 100 ms */
+
+#define NS_IN_1S 1000000000LL
+
+struct hwts_msg {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t type;
+    uint8_t reserved[7];
+    uint64_t tx_hw_ns; /* follow-up only */
+} __attribute__((packed));
+
+struct latency_hist {
+    const char* name;
+    uint32_t bucket[HIST_BUCKETS];
+    uint32_t overflow;
+    uint32_t negative;
+    uint64_t count;
+    int64_t min_ns;
+    int64_t max_ns;
+    double sum_ns;
+};
+
+struct phc_offset {
+    int fd;
+    int64_t offset_ns; /* PHC - CLOCK_REALTIME */
+    int64_t updated_ns;
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static int64_t timespec_ns(const struct timespec* ts) {
+    return (int64_t)ts->tv_sec * NS_IN_1S + ts->tv_nsec;
+}
+
+static int64_t realtime_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return timespec_ns(&ts);
+}
+
+static void hist_add(struct latency_hist* hist, int64_t ns) {
+    if (!hist->count || ns < hist->min_ns) {
+        hist->min_ns = ns;
+    }
+    if (!hist->count || ns > hist->max_ns) {
+        hist->max_ns = ns;
+    }
+    hist->count++;
+    hist->sum_ns += ns;
+
+    if (ns < 0) {
+        hist->negative++;
+    } else if (ns / 1000 < HIST_BUCKETS) {
+        hist->bucket[ns / 1000]++;
+    } else {
+        hist->overflow++;
+    }
+}
+
+/* returns the upper bound of the bucket holding the given percentile, in us */
+static double hist_percentile(const struct latency_hist* hist, double percentile) {
+    uint64_t target = (uint64_t)(hist->count * percentile / 100.0);
+    uint64_t sum = hist->negative;
+
+    if (target >= hist->count) {
+        target = hist->count - 1;
+    }
+    if (sum > target) {
+        return 0;
+    }
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        sum += hist->bucket[i];
+        if (sum > target) {
+            return i + 1;
+        }
+    }
+
+    return hist->max_ns / 1000.0;
+}
+
+static void hist_print(const struct latency_hist* hist) {
+    if (!hist->count) {
+        printf("%s: no samples\n", hist->name);
+        return;
+    }
+
+    printf("%s: %llu samples, min %.1f us, avg %.1f us, p50 %.0f us, p99 %.0f us, p99.9 %.0f us, max %.1f us\n",
+           hist->name, (unsigned long long)hist->count, hist->min_ns / 1000.0, hist->sum_ns / hist->count / 1000.0,
+           hist_percentile(hist, 50.0), hist_percentile(hist, 99.0), hist_percentile(hist, 99.9),
+           hist->max_ns / 1000.0);
+    if (hist->negative) {
+        printf("  %u negative samples, are the clocks synchronized?\n", hist->negative);
+    }
+    if (hist->overflow) {
+        printf("  %u samples above %d us\n", hist->overflow, HIST_BUCKETS);
+    }
+}
+
+static int enable_hw_timestamping(int sockfd, const char* ifname) {
+    struct hwtstamp_config config;
+    struct ifreq ifr;
+
+    memset(&config, 0, sizeof(config));
+    config.tx_type = HWTSTAMP_TX_ON;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name) - 1);
+    ifr.ifr_data = (char*)&config;
+
+    if (ioctl(sockfd, SIOCSHWTSTAMP, &ifr) < 0) {
+        perror("SIOCSHWTSTAMP error");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int open_phc(int sockfd, const char* ifname) {
+    struct ethtool_ts_info info;
+    struct ifreq ifr;
+    char path[32];
+    int fd;
+
+    memset(&info, 0, sizeof(info));
+    info.cmd = ETHTOOL_GET_TS_INFO;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name) - 1);
+    ifr.ifr_data = (char*)&info;
+
+    if (ioctl(sockfd, SIOCETHTOOL, &ifr) < 0 || info.phc_index < 0) {
+        perror("Failed to get the PHC of the interface");
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "/dev/ptp%d", info.phc_index);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open the PHC");
+    }
+
+    return fd;
+}
+
+/* keeps the sample with the shortest system clock window around the PHC read */
+static int update_phc_offset(struct phc_offset* phc) {
+    struct ptp_sys_offset req;
+    int64_t best_delay = INT64_MAX;
+    int64_t now = realtime_ns();
+
+    if (now - phc->updated_ns < OFFSET_REFRESH_NS) {
+        return 0;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.n_samples = OFFSET_SAMPLES;
+    if (ioctl(phc->fd, PTP_SYS_OFFSET, &req) < 0) {
+        perror("PTP_SYS_OFFSET error");
+        return -1;
+    }
+
+    /* ts[] is sys, phc, sys, phc, ..., sys */
+    for (unsigned int i = 0; i < req.n_samples; i++) {
+        int64_t sys1 = req.ts[2 * i].sec * NS_IN_1S + req.ts[2 * i].nsec;
+        int64_t phc_ns = req.ts[2 * i + 1].sec * NS_IN_1S + req.ts[2 * i + 1].nsec;
+        int64_t sys2 = req.ts[2 * i + 2].sec * NS_IN_1S + req.ts[2 * i + 2].nsec;
+
+        if (sys2 - sys1 < best_delay) {
+            best_delay = sys2 - sys1;
+            phc->offset_ns = phc_ns - (sys1 + (sys2 - sys1) / 2);
+        }
+    }
+    phc->updated_ns = now;
+
+    return 0;
+}
+
+static int enable_so_timestamping(int sockfd) {
+    int flags = SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE |
+                SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY | SOF_TIMESTAMPING_OPT_TX_SWHW;
+
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+        perror("SO_TIMESTAMPING error");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int open_socket(const char* ifname, int ifindex, uint16_t protocol) {
+    struct sockaddr_ll addr;
+    int sockfd;
+
+    sockfd = socket(AF_PACKET, SOCK_DGRAM, htons(protocol));
+    if (sockfd < 0) {
+        perror("socket error");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(protocol);
+    addr.sll_ifindex = ifindex;
+    if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind error");
+        close(sockfd);
+        return -1;
+    }
+
+    if (enable_hw_timestamping(sockfd, ifname) < 0 || enable_so_timestamping(sockfd) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
+}
+
+/* returns the SCM_TIMESTAMPING cmsg of msg, NULL if there is none */
+static struct scm_timestamping* get_timestamping(struct msghdr* msg) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            return (struct scm_timestamping*)CMSG_DATA(cmsg);
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t get_timestamp_id(struct msghdr* msg) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        struct sock_extended_err* serr = (struct sock_extended_err*)CMSG_DATA(cmsg);
+
+        if (cmsg->cmsg_level == SOL_PACKET && cmsg->cmsg_type == PACKET_TX_TIMESTAMP &&
+            serr->ee_errno == ENOMSG && serr->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+            return serr->ee_data;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+/* waits for the software and hardware tx timestamps of the frame with the given OPT_ID */
+static int get_tx_timestamps(int sockfd, uint32_t id, int64_t* tx_sw_ns, int64_t* tx_hw_ns) {
+    struct pollfd pfd = {.fd = sockfd, .events = POLLPRI};
+    char control[512];
+    struct msghdr msg;
+    int64_t deadline = realtime_ns() + TX_TIMESTAMP_TIMEOUT_MS * 1000000LL;
+
+    *tx_sw_ns = 0;
+    *tx_hw_ns = 0;
+
+    while (!*tx_hw_ns) {
+        int wait_ms = (int)((deadline - realtime_ns()) / 1000000);
+        struct scm_timestamping* tss;
+
+        if (wait_ms <= 0 || poll(&pfd, 1, wait_ms) <= 0) {
+            return -1;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            continue;
+        }
+
+        tss = get_timestamping(&msg);
+        if (!tss || get_timestamp_id(&msg) != id) {
+            continue;
+        }
+        if (tss->ts[0].tv_sec || tss->ts[0].tv_nsec) {
+            *tx_sw_ns = timespec_ns(&tss->ts[0]);
+        }
+        if (tss->ts[2].tv_sec || tss->ts[2].tv_nsec) {
+            *tx_hw_ns = timespec_ns(&tss->ts[2]);
+        }
+    }
+
+    return 0;
+}
+
+static int send_msg(int sockfd, int ifindex, const uint8_t* dst, struct hwts_msg* payload, int length) {
+    uint8_t frame[MAX_FRAME_SIZE];
+    struct sockaddr_ll addr;
+
+    memset(frame, 0, length);
+    memcpy(frame, payload, sizeof(*payload));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_HWTS);
+    addr.sll_ifindex = ifindex;
+    addr.sll_halen = ETH_ALEN;
+    memcpy(addr.sll_addr, dst, ETH_ALEN);
+
+    if (sendto(sockfd, frame, length, 0, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("sendto error");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int run_sender(const char* ifname, int ifindex, const uint8_t* dst, int count, int interval_us, int length) {
+    static struct latency_hist spi_to_wire = {.name = "SPI to wire"};
+    struct phc_offset phc = {0};
+    int sockfd, missing = 0;
+    uint32_t id = 0;
+
+    /* sends only, nothing to receive */
+    sockfd = open_socket(ifname, ifindex, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+    phc.fd = open_phc(sockfd, ifname);
+    if (phc.fd < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    for (int seq = 0; seq < count && !stop; seq++) {
+        struct hwts_msg msg = {.magic = htonl(HWTS_MAGIC), .seq = htonl(seq), .type = MSG_DATA};
+        int64_t tx_sw_ns, tx_hw_ns;
+
+        if (update_phc_offset(&phc) < 0 || send_msg(sockfd, ifindex, dst, &msg, length) < 0) {
+            break;
+        }
+
+        /* every send bumps the OPT_ID counter, the follow-up too */
+        if (get_tx_timestamps(sockfd, id++, &tx_sw_ns, &tx_hw_ns) < 0) {
+            missing++;
+        } else {
+            if (tx_sw_ns) {
+                hist_add(&spi_to_wire, tx_hw_ns - phc.offset_ns - tx_sw_ns);
+            }
+
+            msg.type = MSG_FOLLOW_UP;
+            msg.tx_hw_ns = htobe64((uint64_t)tx_hw_ns);
+            if (send_msg(sockfd, ifindex, dst, &msg, length) < 0) {
+                break;
+            }
+            id++;
+        }
+
+        usleep(interval_us);
+    }
+
+    printf("Missing hardware tx timestamps: %d\n", missing);
+    hist_print(&spi_to_wire);
+
+    close(phc.fd);
+    close(sockfd);
+
+    return 0;
+}
+
+static int run_receiver(const char* ifname, int ifindex, int count) {
+    static struct latency_hist one_way = {.name = "One-way wire"};
+    static struct latency_hist wire_to_socket = {.name = "Wire to socket"};
+    static int64_t rx_hw_ns[RX_RING_SIZE];
+    static uint32_t rx_seq[RX_RING_SIZE];
+    struct phc_offset phc = {0};
+    uint8_t frame[MAX_FRAME_SIZE];
+    char control[512];
+    int sockfd, received = 0;
+
+    sockfd = open_socket(ifname, ifindex, ETH_P_HWTS);
+    if (sockfd < 0) {
+        return -1;
+    }
+    phc.fd = open_phc(sockfd, ifname);
+    if (phc.fd < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    while (received < count && !stop) {
+        struct iovec iov = {.iov_base = frame, .iov_len = sizeof(frame)};
+        struct msghdr msg;
+        struct scm_timestamping* tss;
+        struct hwts_msg payload;
+        int64_t now_ns, hw_ns;
+        uint32_t seq;
+        ssize_t n;
+
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        n = recvmsg(sockfd, &msg, 0);
+        now_ns = realtime_ns();
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("recvmsg error");
+            break;
+        }
+        if (n < (ssize_t)sizeof(payload)) {
+            continue;
+        }
+
+        memcpy(&payload, frame, sizeof(payload));
+        if (ntohl(payload.magic) != HWTS_MAGIC) {
+            continue;
+        }
+        seq = ntohl(payload.seq);
+
+        if (payload.type == MSG_FOLLOW_UP) {
+            if (rx_seq[seq % RX_RING_SIZE] == seq && rx_hw_ns[seq % RX_RING_SIZE]) {
+                hist_add(&one_way, rx_hw_ns[seq % RX_RING_SIZE] - (int64_t)be64toh(payload.tx_hw_ns));
+                received++;
+            }
+            continue;
+        }
+
+        tss = get_timestamping(&msg);
+        hw_ns = tss ? timespec_ns(&tss->ts[2]) : 0;
+        rx_seq[seq % RX_RING_SIZE] = seq;
+        rx_hw_ns[seq % RX_RING_SIZE] = hw_ns;
+        if (!hw_ns || update_phc_offset(&phc) < 0) {
+            continue;
+        }
+        hist_add(&wire_to_socket, now_ns - (hw_ns - phc.offset_ns));
+    }
+
+    hist_print(&one_way);
+    hist_print(&wire_to_socket);
+
+    close(phc.fd);
+    close(sockfd);
+
+    return 0;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s -i <interface> [-s <destination_mac>] [-c <count>] [-p <interval_us>] [-l <frame_length>]\n",
+           prog);
+    printf("  -i  lan865x interface, e.g. eth1\n");
+    printf("  -s  send to destination_mac, otherwise receive\n");
+    printf("  -c  frames to send or to receive (default %d)\n", DEFAULT_COUNT);
+    printf("  -p  interval between frames in us (default %d)\n", DEFAULT_INTERVAL_US);
+    printf("  -l  frame length without FCS, %d to %d (default %d)\n", (int)(ETH_HLEN + sizeof(struct hwts_msg)),
+           MAX_FRAME_SIZE, DEFAULT_LENGTH);
+}
+
+int main(int argc, char* argv[]) {
+    const char* ifname = NULL;
+    uint8_t dst[ETH_ALEN];
+    int sender = 0, count = DEFAULT_COUNT, interval_us = DEFAULT_INTERVAL_US, length = DEFAULT_LENGTH;
+    int ifindex, opt, ret;
+
+    /* check arguments */
+    while ((opt = getopt(argc, argv, "i:s:c:p:l:")) != -1) {
+        switch (opt) {
+        case 'i':
+            ifname = optarg;
+            break;
+        case 's':
+            if (sscanf(optarg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &dst[0], &dst[1], &dst[2], &dst[3], &dst[4],
+                       &dst[5]) != ETH_ALEN) {
+                printf("Invalid MAC address: %s\n", optarg);
+                exit(1);
+            }
+            sender = 1;
+            break;
+        case 'c':
+            count = atoi(optarg);
+            break;
+        case 'p':
+            interval_us = atoi(optarg);
+            break;
+        case 'l':
+            length = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (!ifname || count < 1 || interval_us < 0 || length < (int)(ETH_HLEN + sizeof(struct hwts_msg)) ||
+        length > MAX_FRAME_SIZE) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    ifindex = if_nametoindex(ifname);
+    if (!ifindex) {
+        perror("Unknown interface");
+        exit(1);
+    }
+
+    signal(SIGINT, on_signal);
+
+    /* the frame length includes the ethernet header, the kernel adds it */
+    if (sender) {
+        ret = run_sender(ifname, ifindex, dst, count, interval_us, length - ETH_HLEN);
+    } else {
+        ret = run_receiver(ifname, ifindex, count);
+    }
+
+    return ret ? 1 : 0;
+}
@@ -1,7 +1,12 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -13,34 +18,381 @@
 #define UDPHDRSIZE 8
 #define FCSSIZE 4
 
-char* generate_random_message(int length) {
-    char* message = malloc(length + 1);
+#define PROGRESS_BAR_WIDTH 50
+
+/* benchmark mode */
+#define POOL_SIZE 256
+#define MAX_BATCH 64
+#define DEFAULT_WINDOW 8
+#define DEFAULT_BATCH 8
+#define RECV_TIMEOUT_MS 1000
+#define HIST_BUCKETS 100000 /* 1 us each, up to 100 ms */
+
+/* every benchmark message starts with this header, the rest is the payload of pool entry seq % POOL_SIZE */
+struct msg_header {
+    uint32_t seq;
+    uint32_t checksum;
+};
+
+#define MSGHDRSIZE ((int)sizeof(struct msg_header))
+
+enum pkt_state { PKT_PENDING = 0, PKT_RECEIVED, PKT_LOST };
+
+struct payload_pool {
+    uint8_t* payload[POOL_SIZE];
+    uint32_t checksum[POOL_SIZE];
+    int length;
+};
+
+struct latency_hist {
+    uint32_t bucket[HIST_BUCKETS];
+    uint32_t overflow;
+    uint64_t count;
+    uint64_t max_ns;
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* FNV-1a */
+static uint32_t checksum(const uint8_t* data, int length) {
+    uint32_t hash = 2166136261U;
+
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+static void fill_random(uint8_t* buf, int length) {
     for (int i = 0; i < length; i++) {
-        message[i] = rand() % 26 + 'a';
+        buf[i] = rand() % 26 + 'a';
+    }
+}
+
+static void print_progress(int done, int count) {
+    char bar[PROGRESS_BAR_WIDTH + 1];
+    int filled = (int)((int64_t)done * PROGRESS_BAR_WIDTH / count);
+
+    memset(bar, '#', filled);
+    memset(bar + filled, ' ', PROGRESS_BAR_WIDTH - filled);
+    bar[PROGRESS_BAR_WIDTH] = 0;
+
+    printf("Progress-Bar [%s] (%.2f%%)%c", bar, (done * 100.0) / count, done == count ? '\n' : '\r');
+    fflush(stdout);
+}
+
+static void hist_add(struct latency_hist* hist, uint64_t ns) {
+    uint64_t us = ns / 1000;
+
+    if (us < HIST_BUCKETS) {
+        hist->bucket[us]++;
+    } else {
+        hist->overflow++;
+    }
+    if (ns > hist->max_ns) {
+        hist->max_ns = ns;
+    }
+    hist->count++;
+}
+
+/* returns the upper bound of the bucket holding the given percentile, in us */
+static double hist_percentile(const struct latency_hist* hist, double percentile) {
+    uint64_t target = (uint64_t)(hist->count * percentile / 100.0);
+    uint64_t sum = 0;
+
+    if (target >= hist->count) {
+        target = hist->count - 1;
+    }
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        sum += hist->bucket[i];
+        if (sum > target) {
+            return i + 1;
+        }
+    }
+
+    return hist->max_ns / 1000.0;
+}
+
+/* stop-and-wait: one message in flight, checked byte by byte */
+static int run_integrity_check(int sockfd, struct sockaddr_in* servaddr, int msglen, int count) {
+    uint8_t* sendbuf = malloc(msglen);
+    uint8_t recvbuf[BUFSIZE];
+    struct sockaddr_in cliaddr;
+    int n, success = 0, fail = 0;
+
+    if (!sendbuf) {
+        perror("malloc error");
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        fill_random(sendbuf, msglen);
+
+        /* send message */
+        if (sendto(sockfd, sendbuf, msglen, 0, (struct sockaddr*)servaddr, sizeof(*servaddr)) < 0) {
+            perror("sendto error");
+            free(sendbuf);
+            return -1;
+        }
+
+        /* receive message */
+        socklen_t len = sizeof(cliaddr);
+        n = recvfrom(sockfd, recvbuf, BUFSIZE, 0, (struct sockaddr*)&cliaddr, &len);
+        if (n < 0) {
+            perror("recvfrom error");
+            free(sendbuf);
+            return -1;
+        }
+
+        /* check message */
+        if (n != msglen || memcmp(sendbuf, recvbuf, msglen) != 0) {
+            printf("Fail: sent message [%.*s] does not match received message [%.*s]\n", msglen, sendbuf, n, recvbuf);
+            fail++;
+        } else {
+            success++;
+        }
+
+        print_progress(i + 1, count);
+    }
+
+    free(sendbuf);
+
+    /* print results */
+    printf("Sent and received %d messages\n", count);
+    printf("Success: %d\n", success);
+    printf("Fail: %d\n", fail);
+
+    return 0;
+}
+
+static int init_pool(struct payload_pool* pool, int msglen) {
+    pool->length = msglen - MSGHDRSIZE;
+
+    for (int i = 0; i < POOL_SIZE; i++) {
+        pool->payload[i] = malloc(pool->length);
+        if (!pool->payload[i]) {
+            return -1;
+        }
+        fill_random(pool->payload[i], pool->length);
+        pool->checksum[i] = checksum(pool->payload[i], pool->length);
     }
-    message[length] = 0;
-    return message;
+
+    return 0;
+}
+
+static void free_pool(struct payload_pool* pool) {
+    for (int i = 0; i < POOL_SIZE; i++) {
+        free(pool->payload[i]);
+    }
+}
+
+/* windowed: up to window messages in flight, sent and received in batches */
+static int run_benchmark(int sockfd, struct sockaddr_in* servaddr, int msglen, int count, int window, int batch,
+                         int frame_size) {
+    static struct payload_pool pool;
+    static struct latency_hist hist;
+    struct msg_header tx_hdr[MAX_BATCH];
+    struct iovec tx_iov[MAX_BATCH][2];
+    struct mmsghdr tx_msgs[MAX_BATCH];
+    uint8_t rx_buf[MAX_BATCH][BUFSIZE];
+    struct iovec rx_iov[MAX_BATCH];
+    struct mmsghdr rx_msgs[MAX_BATCH];
+    uint64_t* sent_ns = calloc(count, sizeof(*sent_ns));
+    uint8_t* state = calloc(count, sizeof(*state));
+    int sent = 0, inflight = 0, received = 0, lost = 0, corrupt = 0, late = 0, unknown = 0;
+    uint64_t start, elapsed;
+    int ret = -1;
+
+    if (!sent_ns || !state || init_pool(&pool, msglen) < 0) {
+        perror("malloc error");
+        goto out;
+    }
+
+    for (int i = 0; i < MAX_BATCH; i++) {
+        memset(&rx_msgs[i], 0, sizeof(rx_msgs[i]));
+        rx_iov[i].iov_base = rx_buf[i];
+        rx_iov[i].iov_len = BUFSIZE;
+        rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+        rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    start = monotonic_ns();
+    while (received + lost + corrupt < count) {
+        /* fill the window */
+        int n = count - sent;
+
+        if (n > window - inflight) {
+            n = window - inflight;
+        }
+        if (n > batch) {
+            n = batch;
+        }
+        if (n > 0) {
+            uint64_t now = monotonic_ns();
+
+            for (int i = 0; i < n; i++) {
+                uint32_t seq = sent + i;
+
+                tx_hdr[i].seq = htonl(seq);
+                tx_hdr[i].checksum = htonl(pool.checksum[seq % POOL_SIZE]);
+                tx_iov[i][0].iov_base = &tx_hdr[i];
+                tx_iov[i][0].iov_len = MSGHDRSIZE;
+                tx_iov[i][1].iov_base = pool.payload[seq % POOL_SIZE];
+                tx_iov[i][1].iov_len = pool.length;
+                memset(&tx_msgs[i], 0, sizeof(tx_msgs[i]));
+                tx_msgs[i].msg_hdr.msg_name = servaddr;
+                tx_msgs[i].msg_hdr.msg_namelen = sizeof(*servaddr);
+                tx_msgs[i].msg_hdr.msg_iov = tx_iov[i];
+                tx_msgs[i].msg_hdr.msg_iovlen = 2;
+                sent_ns[seq] = now;
+            }
+
+            n = sendmmsg(sockfd, tx_msgs, n, 0);
+            if (n < 0) {
+                perror("sendmmsg error");
+                goto out;
+            }
+            sent += n;
+            inflight += n;
+        }
+
+        /* collect what came back, at least one message */
+        n = recvmmsg(sockfd, rx_msgs, batch, MSG_WAITFORONE, NULL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("recvmmsg error");
+                goto out;
+            }
+            /* nothing for RECV_TIMEOUT_MS, whatever is in flight is gone */
+            for (int seq = sent - 1; seq >= 0 && inflight > 0; seq--) {
+                if (state[seq] == PKT_PENDING) {
+                    state[seq] = PKT_LOST;
+                    lost++;
+                    inflight--;
+                }
+            }
+            inflight = 0;
+            continue;
+        }
+
+        uint64_t now = monotonic_ns();
+        for (int i = 0; i < n; i++) {
+            struct msg_header hdr;
+            uint32_t seq;
+
+            if ((int)rx_msgs[i].msg_len != msglen) {
+                unknown++;
+                continue;
+            }
+            memcpy(&hdr, rx_buf[i], MSGHDRSIZE);
+            seq = ntohl(hdr.seq);
+            if (seq >= (uint32_t)sent) {
+                unknown++;
+                continue;
+            }
+            if (state[seq] != PKT_PENDING) {
+                late++;
+                continue;
+            }
+
+            inflight--;
+            if (ntohl(hdr.checksum) != pool.checksum[seq % POOL_SIZE] ||
+                checksum(rx_buf[i] + MSGHDRSIZE, pool.length) != pool.checksum[seq % POOL_SIZE]) {
+                state[seq] = PKT_LOST;
+                corrupt++;
+                continue;
+            }
+
+            state[seq] = PKT_RECEIVED;
+            received++;
+            hist_add(&hist, now - sent_ns[seq]);
+        }
+    }
+    elapsed = monotonic_ns() - start;
+
+    /* print results */
+    double seconds = elapsed / 1e9;
+
+    printf("Sent %d messages of %d bytes (%d bytes on the wire), window %d, batch %d\n", sent, msglen, frame_size, window,
+           batch);
+    printf("Received: %d\n", received);
+    printf("Lost: %d\n", lost);
+    printf("Corrupt: %d\n", corrupt);
+    if (late || unknown) {
+        printf("Late: %d, Unknown: %d\n", late, unknown);
+    }
+    printf("Elapsed: %.3f s\n", seconds);
+    printf("Rate: %.0f packets/s\n", received / seconds);
+    printf("Goodput: %.3f Mbit/s (UDP payload), %.3f Mbit/s (frames)\n", received * (double)msglen * 8 / seconds / 1e6,
+           received * (double)frame_size * 8 / seconds / 1e6);
+    if (hist.count) {
+        printf("RTT: p50 %.0f us, p99 %.0f us, p99.9 %.0f us, max %.1f us\n", hist_percentile(&hist, 50.0),
+               hist_percentile(&hist, 99.0), hist_percentile(&hist, 99.9), hist.max_ns / 1000.0);
+    }
+
+    ret = 0;
+
+out:
+    free_pool(&pool);
+    free(state);
+    free(sent_ns);
+
+    return ret;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [-b] [-w <window>] [-n <batch>] <destination_ip> <destination_port> <source_ip> <source_port> "
+           "<message_length> <count>\n",
+           prog);
+    printf("  -b           benchmark mode: windowed, batched, RTT histogram and throughput report\n");
+    printf("  -w <window>  messages in flight in benchmark mode (default %d)\n", DEFAULT_WINDOW);
+    printf("  -n <batch>   messages per sendmmsg/recvmmsg in benchmark mode, up to %d (default %d)\n", MAX_BATCH,
+           DEFAULT_BATCH);
 }
 
 int main(int argc, char* argv[]) {
-    int sockfd, n, count, success, fail;
+    int sockfd, count, opt, ret;
     struct sockaddr_in servaddr, cliaddr;
-    char *sendbuf, recvbuf[BUFSIZE];
-
-    float pro_b = 0.0;
-    int pro_p = 0, idx;
-    char buff[100];
+    int benchmark = 0, window = DEFAULT_WINDOW, batch = DEFAULT_BATCH;
 
     /* check arguments */
-    if (argc != 7) {
-        printf("Usage: %s <destination_ip> <destination_port> <source_ip> <source_port> <message_length> <count>\n",
-               argv[0]);
+    while ((opt = getopt(argc, argv, "bw:n:")) != -1) {
+        switch (opt) {
+        case 'b':
+            benchmark = 1;
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        case 'n':
+            batch = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (argc - optind != 6 || window < 1 || batch < 1 || batch > MAX_BATCH) {
+        usage(argv[0]);
         exit(1);
     }
+    argv += optind - 1;
 
     /* parse message length and count */
-    int msglen = atoi(argv[5]) - ETHHDRSIZE - IPHDRSIZE - UDPHDRSIZE - FCSSIZE;
+    int frame_size = atoi(argv[5]);
+    int msglen = frame_size - ETHHDRSIZE - IPHDRSIZE - UDPHDRSIZE - FCSSIZE;
     count = atoi(argv[6]);
+    if (msglen < (benchmark ? MSGHDRSIZE : 1) || msglen > BUFSIZE || count < 1) {
+        printf("Invalid message length or count\n");
+        exit(1);
+    }
 
     /* create socket */
     sockfd = socket(AF_INET, SOCK_DGRAM, 0);
@@ -64,67 +416,20 @@ int main(int argc, char* argv[]) {
     /* initialize random number generator */
     srand(time(NULL));
 
-    /* initialize counters */
-    success = 0;
-    fail = 0;
+    if (benchmark) {
+        struct timeval tv = {.tv_sec = RECV_TIMEOUT_MS / 1000, .tv_usec = (RECV_TIMEOUT_MS % 1000) * 1000};
 
-    /* send and receive messages */
-    for (int i = 0; i < count; i++) {
-        sendbuf = generate_random_message(msglen);
-
-        /* send message */
-        if (sendto(sockfd, sendbuf, strlen(sendbuf), 0, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-            perror("sendto error");
+        if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
+            perror("setsockopt error");
             exit(1);
         }
-
-        /* receive message */
-        socklen_t len = sizeof(cliaddr);
-        n = recvfrom(sockfd, recvbuf, BUFSIZE, 0, (struct sockaddr*)&cliaddr, &len);
-        if (n < 0) {
-            perror("recvfrom error");
-            exit(1);
-        }
-        recvbuf[n] = 0;
-
-        /* check message */
-        if (strcmp(sendbuf, recvbuf) != 0) {
-            printf("Fail: sent message [%s] does not match received message [%s]\n", sendbuf, recvbuf);
-            fail++;
-        } else {
-            success++;
-        }
-
-        /* free message */
-        free(sendbuf);
-
-        pro_b = (i * 100.0) / (count * 1.0);
-        pro_p = (i * 100) / (count);
-        memset(buff, 0, 100);
-        sprintf(buff, "Progress-Bar [");
-        for (idx = 0; idx < (pro_p / 2); idx++)
-            sprintf(buff, "%s%s", buff, "#");
-        for (idx = (pro_p / 2); idx < 50; idx++)
-            sprintf(buff, "%s%s", buff, " ");
-        sprintf(buff, "%s%s (%.2f%%)", buff, "]", pro_b);
-        printf("%s\r", buff);
-        fflush(stdout);
-    }
-
-    memset(buff, 0, 100);
-    sprintf(buff, "Progress-Bar [");
-    for (idx = 0; idx < 50; idx++)
-        sprintf(buff, "%s%s", buff, "#");
-    sprintf(buff, "%s%s (%.2f%%)", buff, "]", 100.00);
-    printf("%s\n", buff);
-
-    /* print results */
-    printf("Sent and received %d messages\n", count);
-    printf("Success: %d\n", success);
-    printf("Fail: %d\n", fail);
+        ret = run_benchmark(sockfd, &servaddr, msglen, count, window, batch, frame_size);
+    } else {
+        ret = run_integrity_check(sockfd, &servaddr, msglen, count);
+    }
 
     /* close socket */
     close(sockfd);
 
-    return 0;
+    return ret ? 1 : 0;
 }
@@ -168,3 +168,92 @@ int spi_receive_frame(unsigned int handle, uint8_t* packet, uint16_t* length);
  */
 int spi_receive_frame_with_timestamp(unsigned int handle, uint8_t* packet, uint16_t* length,
                                      struct timestamp_format* timestamp);
+
+/* MAC-PHY interrupt (IRQn) line, as wired in the device tree */
+#define LAN865X_IRQ_GPIO_CHIP "/dev/gpiochip0"
+#define LAN865X_IRQ_GPIO_LINE 23
+
+/**
+ * Request the MAC-PHY interrupt line through the GPIO character device
+ * The returned descriptor becomes readable when the MAC-PHY asserts IRQn, so it can be added to poll/epoll sets
+ * @param chip, GPIO chip device, e.g. LAN865X_IRQ_GPIO_CHIP
+ * @param line, GPIO line offset of IRQn, e.g. LAN865X_IRQ_GPIO_LINE
+ * @return file descriptor (>=0) if OK, otherwise ERR_IRQ_OPEN_FAILED.
+ */
+int spi_irq_open(const char* chip, unsigned int line);
+
+/**
+ * Wait until the MAC-PHY asserts IRQn, returns immediately if it is asserted already
+ * IRQn stays asserted until the next data transfer, so call this only after the pending data has been read
+ * @param irq_fd>=0, as returned by a call to spi_irq_open
+ * @param timeout_ms, maximum time to wait in milliseconds, -1 to wait forever
+ * @return RET_SUCCESS if IRQn is asserted, otherwise ERR_RECEIVE_TIMEOUT or ERR_IRQ_WAIT_FAIL.
+ */
+int spi_irq_wait(int irq_fd, int timeout_ms);
+
+/**
+ * Release the MAC-PHY interrupt line
+ * @param irq_fd>=0, as returned by a call to spi_irq_open
+ * @return 0 if OK, otherwise -RET_FAIL.
+ */
+int spi_irq_close(int irq_fd);
+
+/**
+ * Receive a packet, sleep on IRQn instead of polling the MAC-PHY while no frame is available
+ * STATUS0 events which assert IRQn without a frame are cleared, except the timestamp captures
+ * @param handle>=0, as returned by a call to spi_init
+ * @param irq_fd>=0, as returned by a call to spi_irq_open
+ * @param * packet, Buffer pointer to store received packet
+ * @param * length, Variable pointer to store the length of the received packet
+ * @param timeout_ms, maximum time to wait in milliseconds, -1 to wait forever
+ * @return RET_SUCCESS if OK, ERR_RECEIVE_TIMEOUT if no frame arrived in time, otherwise error code.
+ */
+int spi_receive_frame_wait(unsigned int handle, int irq_fd, uint8_t* packet, uint16_t* length, int timeout_ms);
+
+/**
+ * Receive a packet with its ingress timestamp, sleep on IRQn instead of polling the MAC-PHY while no frame is
+ * available
+ * STATUS0 events which assert IRQn without a frame are cleared, except the timestamp captures
+ * @param handle>=0, as returned by a call to spi_init
+ * @param irq_fd>=0, as returned by a call to spi_irq_open
+ * @param * packet, Buffer pointer to store received packet
+ * @param * length, Variable pointer to store the length of the received packet
+ * @param * timestamp Address of variable to store ingress timestamp value
+ * @param timeout_ms, maximum time to wait in milliseconds, -1 to wait forever
+ * @return RET_SUCCESS if OK, ERR_RECEIVE_TIMEOUT if no frame arrived in time, otherwise error code.
+ */
+int spi_receive_frame_with_timestamp_wait(unsigned int handle, int irq_fd, uint8_t* packet, uint16_t* length,
+                                          struct timestamp_format* timestamp, int timeout_ms);
+
+/* One Ethernet frame of a vectored transmit or receive */
+struct spi_frame {
+    uint8_t* packet; /* Starting address of the frame */
+    uint16_t length; /* TX: frame length, RX: length of the received frame */
+    uint16_t size;   /* RX: size of the packet buffer */
+#ifdef FRAME_TIMESTAMP_ENABLE
+    int timestamp_reg;                 /* TX: TTSC_NO or the Transmit Timestamp Capture register */
+    int has_timestamp;                 /* RX: 1 if timestamp holds the ingress timestamp */
+    struct timestamp_format timestamp; /* RX: ingress timestamp */
+#endif
+};
+
+/**
+ * Transmit up to count frames, packing as many of them as the transmit credits allow into each SPI transfer
+ * Frames are only sent whole, a frame which does not fit into the credits left ends the call
+ * @param handle>=0, as returned by a call to spi_init
+ * @param * frames, frames to be transmitted, in order
+ * @param count, number of frames
+ * @return number of frames transmitted (>0) if OK, otherwise ERR_NOT_ENOUGH_CREDITS or ERR_SPI_TRANSMIT_FAIL.
+ */
+int spi_transmit_frames(unsigned int handle, struct spi_frame* frames, int count);
+
+/**
+ * Receive up to count frames, clocking as many receive chunks as are available into each SPI transfer
+ * Frames which don't fit into frames[] are kept for the next call
+ * @param handle>=0, as returned by a call to spi_init
+ * @param * frames, buffers for the received frames
+ * @param count, number of buffers
+ * @return number of frames received (>0) if OK, otherwise ERR_NO_RECEIVED_FRAME, ERR_SPI_RECEIVE_FAIL or
+ *         ERR_RECEIVE_FRAME_DROP.
+ */
+int spi_receive_frames(unsigned int handle, struct spi_frame* frames, int count);
@@ -2,9 +2,14 @@
 
 #include <stdint.h>
 
+/* Maximum SPI clock of the MAC-PHY, as allowed by the device tree */
+#define SPI_MAX_SPEED_HZ 25000000
+
 /**
  * Configures pigpio to use a particular sample rate timed by a specified peripheral.
  * Opens a SPI device
+ * With the spidev backend, opens SPIDEV_DEVICE at SPI_SPEED_HZ as set at configure time
+ * With the sim backend, creates a simulated MAC-PHY, see sim.h
  * @return handle (>=0) if OK, otherwise ERR_BAD_SPI_CHANNEL, ERR_BAD_SPI_SPEED, ERR_BAD_FLAGS, ERR_NO_AUX_SPI, or
  * ERR_SPI_OPEN_FAILED
  */
@@ -26,3 +31,31 @@ int spi_transfer(unsigned int handle, uint8_t* rxbuffer, uint8_t* txbuffer, uint
  * @return 0 if OK, otherwise ERR_BAD_HANDLE.
  */
 int spi_close(unsigned int handle);
+
+/* One transfer of a spi_transfer_vec() submission */
+struct spi_xfer {
+    uint8_t* rxbuffer; /* the received data bytes, may be NULL */
+    uint8_t* txbuffer; /* the data bytes to write, may be NULL to clock out zeros */
+    uint16_t count;    /* the number of bytes to transfer */
+    uint8_t cs_change; /* deassert chip select after this transfer, ignored on the last one */
+};
+
+/**
+ * Opens the SPI device at path with the given clock (spidev backend)
+ * With the sim backend, path is the name of the simulated segment
+ * @param path, spidev device, e.g. "/dev/spidev0.0"
+ * @param speed_hz, SPI clock in Hz, up to SPI_MAX_SPEED_HZ
+ * @return handle (>=0) if OK, otherwise ERR_BAD_SPI_SPEED or ERR_SPI_OPEN_FAILED
+ */
+int spi_open_device(const char* path, uint32_t speed_hz);
+
+/**
+ * Submits count transfers to the SPI device in one go, chip select stays asserted between them unless cs_change is
+ * set. Chip select is always deasserted at the end. With the spidev backend this is a single SPI_IOC_MESSAGE(count)
+ * ioctl.
+ * @param handle. >=0, as returned by a call to spi_init
+ * @param xfers, transfers to be done, in order
+ * @param count, the number of transfers
+ * @return the number of bytes transferred if OK, otherwise ERR_BAD_HANDLE, ERR_BAD_SPI_COUNT, or ERR_SPI_XFER_FAILED.
+ */
+int spi_transfer_vec(unsigned int handle, struct spi_xfer* xfers, int count);
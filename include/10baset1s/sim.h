@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Simulated nodes on one segment at most */
+#define SIM_MAX_NODES 8
+
+/* Environment variables read by spi_open() with the simulator backend */
+#define SIM_SEGMENT_ENV "SIM_SEGMENT"
+#define SIM_NODE_ID_ENV "SIM_NODE_ID"
+#define SIM_DEFAULT_SEGMENT "default"
+
+/**
+ * Creates a simulated LAN8650 MAC-PHY attached to a virtual multidrop segment
+ * Frames transmitted by a node are received by all other nodes of the same segment, also across processes
+ * spi_open() calls this with the segment and node id from SIM_SEGMENT_ENV and SIM_NODE_ID_ENV
+ * @param segment, name of the virtual segment
+ * @param node_id, 0 to SIM_MAX_NODES - 1, unique on the segment
+ * @return handle (>=0) if OK, otherwise ERR_UNKNOWN_PARAMETER or ERR_SPI_OPEN_FAILED
+ */
+int sim_open(const char* segment, int node_id);
+
+/**
+ * Returns how many frames the node sent which did not reach a node in another process
+ * Nodes in the same process always get a frame, unless their RX buffer is full (STATUS0 RXBOE). A node in another
+ * process loses it when its host doesn't poll within 10 ms and the socket queue in between is full.
+ * @param handle, as returned by sim_open()
+ * @return the number of frames (>=0) if OK, otherwise ERR_BAD_HANDLE
+ */
+int sim_dropped_frames(unsigned int handle);
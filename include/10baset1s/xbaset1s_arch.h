@@ -69,6 +69,9 @@ struct timestamp_format {
 #define ERR_NO_RECEIVED_FRAME (-102)  /* no Ethernet frame data available for reading */
 #define ERR_SPI_RECEIVE_FAIL (-103)   /* Fail to spi_receive_frame */
 #define ERR_RECEIVE_FRAME_DROP (-104) /* Receive Frame Drop */
+#define ERR_RECEIVE_TIMEOUT (-105)    /* no Ethernet frame received within the timeout */
+#define ERR_IRQ_OPEN_FAILED (-106)    /* can't request the MAC-PHY IRQ GPIO line */
+#define ERR_IRQ_WAIT_FAIL (-107)      /* Fail to wait for the MAC-PHY IRQ */
 
 #define ERR_INIT_FAILED (-1)      /* gpioInitialise failed */
 #define ERR_BAD_HANDLE (-25)      /* unknown handle */
@@ -0,0 +1,426 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <10baset1s/lan865x.h>
+#include <10baset1s/rpi_spi.h>
+#include <10baset1s/xbaset1s_arch.h>
+
+#define CHUNK_PAYLOAD_SIZE 64
+#define DATA_HEADER_SIZE 4
+#define DATA_FOOTER_SIZE 4
+#define CHUNK_SIZE (DATA_HEADER_SIZE + CHUNK_PAYLOAD_SIZE)
+
+/* Chunks clocked in one SPI transfer at most */
+#define MAX_BURST_CHUNKS 48
+
+#define MMS0 0x00
+#define REG_BUFFER_STATUS 0x000B
+#define BUFFER_STATUS_TXC_SHIFT 8
+#define BUFFER_STATUS_MASK 0xFF
+
+/* Data header */
+#define DATA_HEADER_DNC (1U << 31)
+#define DATA_HEADER_NORX (1U << 29)
+#define DATA_HEADER_DV (1U << 21)
+#define DATA_HEADER_SV (1U << 20)
+#define DATA_HEADER_EV (1U << 14)
+#define DATA_HEADER_EBO_SHIFT 8
+#define DATA_HEADER_TSC_SHIFT 6
+
+/* Data footer */
+#define DATA_FOOTER_HDRB (1U << 30)
+#define DATA_FOOTER_SYNC (1U << 29)
+#define DATA_FOOTER_RCA_SHIFT 24
+#define DATA_FOOTER_RCA_MASK 0x1F
+#define DATA_FOOTER_DV (1U << 21)
+#define DATA_FOOTER_SV (1U << 20)
+#define DATA_FOOTER_SWO_SHIFT 16
+#define DATA_FOOTER_SWO_MASK 0xF
+#define DATA_FOOTER_FD (1U << 15)
+#define DATA_FOOTER_EV (1U << 14)
+#define DATA_FOOTER_EBO_SHIFT 8
+#define DATA_FOOTER_EBO_MASK 0x3F
+#define DATA_FOOTER_RTSA (1U << 7)
+#define DATA_FOOTER_TXC_SHIFT 1
+#define DATA_FOOTER_TXC_MASK 0x1F
+
+#define RX_TIMESTAMP_SIZE 8
+
+/* Received frames kept for the next spi_receive_frames() call */
+#define RX_BACKLOG_FRAMES 8
+#define RX_FRAME_MAX_SIZE 2048
+#define MAX_HANDLES 4
+
+struct rx_frame {
+    uint8_t packet[RX_FRAME_MAX_SIZE];
+    uint16_t length;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    int has_timestamp;
+    struct timestamp_format timestamp;
+#endif
+};
+
+struct burst_state {
+    int used;
+    unsigned int handle;
+    uint8_t tx_buf[MAX_BURST_CHUNKS * CHUNK_SIZE];
+    uint8_t rx_buf[MAX_BURST_CHUNKS * CHUNK_SIZE];
+    struct rx_frame backlog[RX_BACKLOG_FRAMES];
+    int backlog_head;
+    int backlog_count;
+    struct rx_frame partial; /* Frame whose end has not been received yet */
+    int in_frame;
+    int dropping; /* The frame being received doesn't fit, skip it up to its end */
+};
+
+/* Frames handed out by one spi_receive_frames() call */
+struct rx_output {
+    struct spi_frame* frames;
+    int count;
+    int received;
+    int dropped;
+};
+
+static struct burst_state states[MAX_HANDLES];
+
+static struct burst_state* get_state(unsigned int handle) {
+    struct burst_state* free_state = NULL;
+
+    for (int i = 0; i < MAX_HANDLES; i++) {
+        if (states[i].used && states[i].handle == handle) {
+            return &states[i];
+        }
+        if (!states[i].used && !free_state) {
+            free_state = &states[i];
+        }
+    }
+
+    if (free_state) {
+        memset(free_state, 0, sizeof(*free_state));
+        free_state->used = 1;
+        free_state->handle = handle;
+    }
+
+    return free_state;
+}
+
+static uint32_t get_parity(uint32_t p) {
+    p ^= p >> 1;
+    p ^= p >> 2;
+    p = (p & 0x11111111U) * 0x11111111U;
+
+    /* Odd parity is used here */
+    return !((p >> 28) & 1);
+}
+
+static void put_be32(uint8_t* buf, uint32_t val) {
+    buf[0] = (uint8_t)(val >> 24);
+    buf[1] = (uint8_t)(val >> 16);
+    buf[2] = (uint8_t)(val >> 8);
+    buf[3] = (uint8_t)val;
+}
+
+static uint32_t get_be32(const uint8_t* buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+static void put_data_header(uint8_t* buf, uint32_t header) {
+    header |= DATA_HEADER_DNC;
+    header |= get_parity(header);
+    put_be32(buf, header);
+}
+
+static int read_buffer_status(unsigned int handle, int* tx_credits, int* rx_chunks) {
+    uint32_t regval = read_register(handle, MMS0, REG_BUFFER_STATUS);
+
+    *tx_credits = (int)((regval >> BUFFER_STATUS_TXC_SHIFT) & BUFFER_STATUS_MASK);
+    *rx_chunks = (int)(regval & BUFFER_STATUS_MASK);
+
+    return RET_SUCCESS;
+}
+
+static int frame_chunks(uint16_t length) {
+    return (length + CHUNK_PAYLOAD_SIZE - 1) / CHUNK_PAYLOAD_SIZE;
+}
+
+int spi_transmit_frames(unsigned int handle, struct spi_frame* frames, int count) {
+    struct burst_state* state = get_state(handle);
+    int tx_credits, rx_chunks;
+    int sent = 0;
+
+    if (!state || !frames || count <= 0) {
+        return ERR_UNKNOWN_PARAMETER;
+    }
+
+    read_buffer_status(handle, &tx_credits, &rx_chunks);
+
+    while (sent < count) {
+        int burst_frames = 0;
+        int chunks = 0;
+        uint32_t footer;
+
+        /* Fill the burst with whole frames, up to the credits available */
+        while (sent + burst_frames < count) {
+            struct spi_frame* frame = &frames[sent + burst_frames];
+            int needed = frame_chunks(frame->length);
+
+            if (!frame->length || chunks + needed > tx_credits || chunks + needed > MAX_BURST_CHUNKS) {
+                break;
+            }
+
+            for (int i = 0; i < needed; i++) {
+                uint8_t* chunk = &state->tx_buf[(chunks + i) * CHUNK_SIZE];
+                uint16_t offset = (uint16_t)(i * CHUNK_PAYLOAD_SIZE);
+                uint16_t len = frame->length - offset;
+                /* Keep the receive data for spi_receive_frames() */
+                uint32_t header = DATA_HEADER_NORX | DATA_HEADER_DV;
+
+                if (len > CHUNK_PAYLOAD_SIZE) {
+                    len = CHUNK_PAYLOAD_SIZE;
+                }
+                if (i == 0) {
+                    header |= DATA_HEADER_SV;
+                }
+                if (i == needed - 1) {
+                    header |= DATA_HEADER_EV | ((uint32_t)(len - 1) << DATA_HEADER_EBO_SHIFT);
+#ifdef FRAME_TIMESTAMP_ENABLE
+                    header |= (uint32_t)(frame->timestamp_reg & TRANSMIT_TIMESTAMP_CAPTURE_MASK)
+                              << DATA_HEADER_TSC_SHIFT;
+#endif
+                }
+
+                put_data_header(chunk, header);
+                memcpy(chunk + DATA_HEADER_SIZE, frame->packet + offset, len);
+            }
+
+            chunks += needed;
+            burst_frames++;
+        }
+
+        if (!burst_frames) {
+            /* The next frame needs more credits than the last footer reported, the MAC-PHY may have freed some
+             * in the meantime */
+            if (frame_chunks(frames[sent].length) > MAX_BURST_CHUNKS || !frames[sent].length) {
+                return sent ? sent : ERR_UNKNOWN_PARAMETER;
+            }
+            read_buffer_status(handle, &tx_credits, &rx_chunks);
+            if (frame_chunks(frames[sent].length) > tx_credits) {
+                return sent ? sent : ERR_NOT_ENOUGH_CREDITS;
+            }
+            continue;
+        }
+
+        /* One contiguous transfer rather than spi_transfer_vec() with the payload in place: the pigpio backend has
+         * no vectored transfer, spidev copies every transfer into its bounce buffer anyway and a header, payload and
+         * padding transfer per chunk would exceed the transfers allowed per message */
+        if (spi_transfer(handle, state->rx_buf, state->tx_buf, (uint16_t)(chunks * CHUNK_SIZE)) < 0) {
+            return sent ? sent : ERR_SPI_TRANSMIT_FAIL;
+        }
+
+        footer = get_be32(&state->rx_buf[chunks * CHUNK_SIZE - DATA_FOOTER_SIZE]);
+        if ((footer & DATA_FOOTER_HDRB) || !(footer & DATA_FOOTER_SYNC)) {
+            return sent ? sent : ERR_SPI_TRANSMIT_FAIL;
+        }
+
+        sent += burst_frames;
+        tx_credits = (int)((footer >> DATA_FOOTER_TXC_SHIFT) & DATA_FOOTER_TXC_MASK);
+    }
+
+    return sent;
+}
+
+static int backlog_push(struct burst_state* state, const struct rx_frame* frame) {
+    if (state->backlog_count == RX_BACKLOG_FRAMES) {
+        return -RET_FAIL;
+    }
+
+    state->backlog[(state->backlog_head + state->backlog_count) % RX_BACKLOG_FRAMES] = *frame;
+    state->backlog_count++;
+
+    return RET_SUCCESS;
+}
+
+static int deliver_frame(const struct rx_frame* rx, struct spi_frame* frame) {
+    if (rx->length > frame->size) {
+        return ERR_RECEIVE_FRAME_DROP;
+    }
+
+    memcpy(frame->packet, rx->packet, rx->length);
+    frame->length = rx->length;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    frame->has_timestamp = rx->has_timestamp;
+    frame->timestamp = rx->timestamp;
+#endif
+
+    return RET_SUCCESS;
+}
+
+/* Completed frames go straight into the caller's buffers, the backlog only takes the ones which don't fit anymore */
+static void complete_rx_frame(struct burst_state* state, uint32_t footer, struct rx_output* out) {
+    state->in_frame = 0;
+
+    if (state->dropping || (footer & DATA_FOOTER_FD)) {
+        out->dropped++;
+        return;
+    }
+
+    if (out->received < out->count) {
+        if (deliver_frame(&state->partial, &out->frames[out->received]) == RET_SUCCESS) {
+            out->received++;
+        } else {
+            out->dropped++;
+        }
+        return;
+    }
+
+    if (backlog_push(state, &state->partial) != RET_SUCCESS) {
+        out->dropped++;
+    }
+}
+
+static void start_rx_frame(struct burst_state* state, const uint8_t* payload, uint32_t footer, int* offset) {
+    state->in_frame = 1;
+    state->dropping = 0;
+    state->partial.length = 0;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    state->partial.has_timestamp = 0;
+    if (footer & DATA_FOOTER_RTSA) {
+        /* The ingress timestamp is placed in front of the frame */
+        state->partial.timestamp.seconds = get_be32(payload + *offset);
+        state->partial.timestamp.nanoseconds = get_be32(payload + *offset + 4);
+        state->partial.has_timestamp = 1;
+        *offset += RX_TIMESTAMP_SIZE;
+    }
+#else
+    (void)payload;
+    (void)footer;
+    (void)offset;
+#endif
+}
+
+static void append_rx_data(struct burst_state* state, const uint8_t* data, int len) {
+    if (len <= 0 || state->dropping) {
+        return;
+    }
+    if (state->partial.length + len > RX_FRAME_MAX_SIZE) {
+        state->dropping = 1;
+        return;
+    }
+
+    memcpy(&state->partial.packet[state->partial.length], data, (size_t)len);
+    state->partial.length += (uint16_t)len;
+}
+
+/* Converts one received chunk, see complete_rx_frame() for where completed frames go */
+static int process_rx_chunk(struct burst_state* state, const uint8_t* payload, uint32_t footer, struct rx_output* out) {
+    int sv = !!(footer & DATA_FOOTER_SV);
+    int ev = !!(footer & DATA_FOOTER_EV);
+    int swo = (int)((footer >> DATA_FOOTER_SWO_SHIFT) & DATA_FOOTER_SWO_MASK) * 4;
+    int ebo = (int)((footer >> DATA_FOOTER_EBO_SHIFT) & DATA_FOOTER_EBO_MASK);
+    int offset;
+
+    if ((footer & DATA_FOOTER_HDRB) || !(footer & DATA_FOOTER_SYNC)) {
+        return ERR_SPI_RECEIVE_FAIL;
+    }
+    if (!(footer & DATA_FOOTER_DV)) {
+        return RET_SUCCESS;
+    }
+
+    /* The end of the ongoing frame comes before the start of the next one */
+    if (ev && (!sv || ebo < swo)) {
+        if (state->in_frame) {
+            append_rx_data(state, payload, ebo + 1);
+            complete_rx_frame(state, footer, out);
+        }
+        ev = 0;
+    }
+
+    if (sv) {
+        offset = swo;
+        start_rx_frame(state, payload, footer, &offset);
+        if (ev) {
+            append_rx_data(state, payload + offset, ebo + 1 - offset);
+            complete_rx_frame(state, footer, out);
+        } else {
+            append_rx_data(state, payload + offset, CHUNK_PAYLOAD_SIZE - offset);
+        }
+    } else if (!ev && state->in_frame) {
+        append_rx_data(state, payload, CHUNK_PAYLOAD_SIZE);
+    }
+
+    return RET_SUCCESS;
+}
+
+int spi_receive_frames(unsigned int handle, struct spi_frame* frames, int count) {
+    struct burst_state* state = get_state(handle);
+    struct rx_output out = {.frames = frames, .count = count};
+    int tx_credits, rx_chunks;
+    int status_read = 0;
+    int ret;
+
+    if (!state || !frames || count <= 0) {
+        return ERR_UNKNOWN_PARAMETER;
+    }
+
+    for (;;) {
+        int chunks;
+
+        /* Hand out what was received earlier first */
+        while (out.received < count && state->backlog_count) {
+            if (deliver_frame(&state->backlog[state->backlog_head], &frames[out.received]) == RET_SUCCESS) {
+                out.received++;
+            } else {
+                out.dropped++;
+            }
+            state->backlog_head = (state->backlog_head + 1) % RX_BACKLOG_FRAMES;
+            state->backlog_count--;
+        }
+        if (out.received == count) {
+            break;
+        }
+
+        if (!status_read) {
+            read_buffer_status(handle, &tx_credits, &rx_chunks);
+            status_read = 1;
+        }
+        if (!rx_chunks) {
+            break;
+        }
+
+        /* Each chunk ends one frame at most. Completed frames fill the buffers left first and only then the
+         * backlog, so sizing the burst to both together keeps the backlog from overflowing */
+        chunks = rx_chunks;
+        if (chunks > MAX_BURST_CHUNKS) {
+            chunks = MAX_BURST_CHUNKS;
+        }
+        if (chunks > (count - out.received) + (RX_BACKLOG_FRAMES - state->backlog_count)) {
+            chunks = (count - out.received) + (RX_BACKLOG_FRAMES - state->backlog_count);
+        }
+
+        for (int i = 0; i < chunks; i++) {
+            put_data_header(&state->tx_buf[i * CHUNK_SIZE], 0);
+        }
+
+        if (spi_transfer(handle, state->rx_buf, state->tx_buf, (uint16_t)(chunks * CHUNK_SIZE)) < 0) {
+            return out.received ? out.received : ERR_SPI_RECEIVE_FAIL;
+        }
+
+        for (int i = 0; i < chunks; i++) {
+            const uint8_t* payload = &state->rx_buf[i * CHUNK_SIZE];
+            uint32_t footer = get_be32(payload + CHUNK_PAYLOAD_SIZE);
+
+            ret = process_rx_chunk(state, payload, footer, &out);
+            if (ret != RET_SUCCESS) {
+                state->in_frame = 0;
+                return out.received ? out.received : ret;
+            }
+            rx_chunks = (int)((footer >> DATA_FOOTER_RCA_SHIFT) & DATA_FOOTER_RCA_MASK);
+        }
+    }
+
+    if (out.received) {
+        return out.received;
+    }
+
+    return out.dropped ? ERR_RECEIVE_FRAME_DROP : ERR_NO_RECEIVED_FRAME;
+}
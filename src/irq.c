@@ -0,0 +1,182 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <10baset1s/lan865x.h>
+#include <10baset1s/xbaset1s_arch.h>
+#include <linux/gpio.h>
+
+#define IRQ_CONSUMER "10baset1s-irq"
+
+#define MMS0 0x00
+#define REG_STATUS0 0x0008
+#define REG_IMASK0 0x000C
+/* Transmit timestamp capture available A to C, cleared by whoever reads the captures */
+#define STATUS0_TTSCA_MASK 0x0700
+
+/* Poll interval while IRQn is held asserted by pending captures, no edge announces a frame then */
+#define IRQ_HELD_POLL_MS 10
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Discard the queued edge events, the level of IRQn is what matters */
+static void drain_irq_events(int irq_fd) {
+    struct gpio_v2_line_event event;
+    struct pollfd pfd = {.fd = irq_fd, .events = POLLIN};
+
+    while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+        if (read(irq_fd, &event, sizeof(event)) != sizeof(event)) {
+            break;
+        }
+    }
+}
+
+/* IRQn is active low */
+static int is_irq_asserted(int irq_fd) {
+    struct gpio_v2_line_values values = {.bits = 0, .mask = 1};
+
+    if (ioctl(irq_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        return 0;
+    }
+
+    return !(values.bits & 1);
+}
+
+int spi_irq_open(const char* chip, unsigned int line) {
+    struct gpio_v2_line_request req;
+    int chip_fd;
+    int ret;
+
+    chip_fd = open(chip, O_RDWR | O_CLOEXEC);
+    if (chip_fd < 0) {
+        return ERR_IRQ_OPEN_FAILED;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    strncpy(req.consumer, IRQ_CONSUMER, sizeof(req.consumer) - 1);
+
+    ret = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    close(chip_fd);
+    if (ret < 0) {
+        return ERR_IRQ_OPEN_FAILED;
+    }
+
+    return req.fd;
+}
+
+static int wait_irq_edge(int irq_fd, int timeout_ms) {
+    struct pollfd pfd = {.fd = irq_fd, .events = POLLIN};
+    int64_t deadline = monotonic_ms() + timeout_ms;
+    int wait_ms = timeout_ms;
+    int ret;
+
+    for (;;) {
+        ret = poll(&pfd, 1, wait_ms);
+        if (ret > 0) {
+            drain_irq_events(irq_fd);
+            return RET_SUCCESS;
+        }
+        if (ret == 0) {
+            return ERR_RECEIVE_TIMEOUT;
+        }
+        if (errno != EINTR) {
+            return ERR_IRQ_WAIT_FAIL;
+        }
+        if (timeout_ms >= 0) {
+            wait_ms = (int)(deadline - monotonic_ms());
+            if (wait_ms <= 0) {
+                return ERR_RECEIVE_TIMEOUT;
+            }
+        }
+    }
+}
+
+int spi_irq_wait(int irq_fd, int timeout_ms) {
+    /* An edge seen before the last data transfer is stale, the level tells whether the MAC-PHY still has something
+     * for us */
+    drain_irq_events(irq_fd);
+    if (is_irq_asserted(irq_fd)) {
+        return RET_SUCCESS;
+    }
+
+    return wait_irq_edge(irq_fd, timeout_ms);
+}
+
+/* Clears the STATUS0 events which assert IRQn, e.g. RESETC or a buffer error. Returns the capture flags left, which
+ * keep IRQn asserted as well if they are not masked */
+static uint32_t ack_irq_events(unsigned int handle) {
+    uint32_t status0 = read_register(handle, MMS0, REG_STATUS0);
+    uint32_t events = status0 & ~read_register(handle, MMS0, REG_IMASK0);
+
+    if (events & ~STATUS0_TTSCA_MASK) {
+        write_register(handle, MMS0, REG_STATUS0, events & ~STATUS0_TTSCA_MASK);
+    }
+
+    return events & STATUS0_TTSCA_MASK;
+}
+
+int spi_irq_close(int irq_fd) {
+    return close(irq_fd) ? -RET_FAIL : RET_SUCCESS;
+}
+
+static int receive_frame_wait(unsigned int handle, int irq_fd, uint8_t* packet, uint16_t* length,
+                              struct timestamp_format* timestamp, int timeout_ms) {
+    int64_t deadline = monotonic_ms() + timeout_ms;
+    int wait_ms = timeout_ms;
+    int ret;
+
+    for (;;) {
+        if (timestamp) {
+            ret = spi_receive_frame_with_timestamp(handle, packet, length, timestamp);
+        } else {
+            ret = spi_receive_frame(handle, packet, length);
+        }
+        if (ret != ERR_NO_RECEIVED_FRAME) {
+            return ret;
+        }
+
+        if (timeout_ms >= 0) {
+            wait_ms = (int)(deadline - monotonic_ms());
+            if (wait_ms <= 0) {
+                return ERR_RECEIVE_TIMEOUT;
+            }
+        }
+
+        /* IRQn asserted without a frame is held by STATUS0, waiting on the level would return right away forever */
+        if (is_irq_asserted(irq_fd) && ack_irq_events(handle)) {
+            drain_irq_events(irq_fd);
+            ret = wait_irq_edge(irq_fd, timeout_ms >= 0 && wait_ms < IRQ_HELD_POLL_MS ? wait_ms : IRQ_HELD_POLL_MS);
+            if (ret == ERR_RECEIVE_TIMEOUT) {
+                continue;
+            }
+        } else {
+            ret = spi_irq_wait(irq_fd, wait_ms);
+        }
+        if (ret != RET_SUCCESS) {
+            return ret;
+        }
+    }
+}
+
+int spi_receive_frame_wait(unsigned int handle, int irq_fd, uint8_t* packet, uint16_t* length, int timeout_ms) {
+    return receive_frame_wait(handle, irq_fd, packet, length, NULL, timeout_ms);
+}
+
+int spi_receive_frame_with_timestamp_wait(unsigned int handle, int irq_fd, uint8_t* packet, uint16_t* length,
+                                          struct timestamp_format* timestamp, int timeout_ms) {
+    return receive_frame_wait(handle, irq_fd, packet, length, timestamp, timeout_ms);
+}
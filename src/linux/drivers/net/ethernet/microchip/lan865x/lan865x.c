@@ -17,6 +17,7 @@
 
 #include "lan865x_arch.h"
 #include "lan865x_ioctl.h"
+#include "lan865x_phy.h"
 #include "lan865x_ptp.h"
 
 #define DRV_NAME "lan8650"
@@ -44,7 +45,25 @@
 /* PLCA Control 1 Register */
 #define LAN865X_REG_PLCA_CTRL1 0x0004ca02
 
+/* PLCA Burst Mode Register */
+#define LAN865X_REG_PLCA_BURST 0x0004ca05
+#define PLCA_BURST_MAXBC GENMASK(15, 8) /* Additional frames per transmit opportunity */
+#define PLCA_BURST_BTMR GENMASK(7, 0)   /* Bit times to wait for the next frame of a burst */
+
+/* ethtool private flags */
+#define LAN865X_PRIV_FLAG_TX_CUT_THROUGH BIT(0)
+#define LAN865X_PRIV_FLAG_RX_CUT_THROUGH BIT(1)
+#define LAN865X_PRIV_FLAG_PLCA_AUTO_BURST BIT(2)
+
+/* PLCA auto burst: bursting is enabled once this many frames wait in the tx
+ * ring and disabled after the ring stayed empty for a number of polls.
+ */
+#define LAN865X_PLCA_BURST_POLL_INTERVAL msecs_to_jiffies(10)
+#define LAN865X_PLCA_BURST_BACKLOG_HIGH 4
+#define LAN865X_PLCA_BURST_IDLE_POLLS 10
+
 /* NOTE: Knob MAX of the T1S HAT board is 16, but the LAN8650 supports a maximum count of only 8. */
+/* Node count set at probe, size it to the segment with ethtool --set-plca-cfg node-cnt */
 #define LAN8650_NODE_MAX_COUNT 8
 #define NODE_ID_BITS_WIDTH 8
 #define NODE_ID_MASK 0xFF
@@ -54,6 +73,14 @@
 #define MAC_ADDR_LENGTH 6
 #define NUM_OF_BITS_IN_BYTE 8
 
+static uint plca_burst_count = 4;
+module_param(plca_burst_count, uint, 0644);
+MODULE_PARM_DESC(plca_burst_count, "Additional frames per PLCA transmit opportunity while auto burst is active (1-255)");
+
+static uint plca_burst_timer = 128;
+module_param(plca_burst_timer, uint, 0644);
+MODULE_PARM_DESC(plca_burst_timer, "Bit times a PLCA burst waits for the next frame while auto burst is active (1-255)");
+
 static int lan865x_set_nodeid(struct lan865x_priv* priv, u32 node_id) {
     u32 regval;
 
@@ -61,6 +88,65 @@ static int lan865x_set_nodeid(struct lan865x_priv* priv, u32 node_id) {
     return oa_tc6_write_register(priv->tc6, LAN865X_REG_PLCA_CTRL1, regval);
 }
 
+/* While auto burst is enabled it owns the PLCA burst register, settings made
+ * with ethtool --set-plca-cfg burst-cnt/burst-tmr are overwritten.
+ */
+static int lan865x_set_plca_burst(struct lan865x_priv* priv, bool enable) {
+    u32 regval;
+
+    regval = FIELD_PREP(PLCA_BURST_BTMR, clamp_val(plca_burst_timer, 1, 255));
+    if (enable)
+        regval |= FIELD_PREP(PLCA_BURST_MAXBC, clamp_val(plca_burst_count, 1, 255));
+
+    return oa_tc6_write_register(priv->tc6, LAN865X_REG_PLCA_BURST, regval);
+}
+
+static void lan865x_plca_burst_stop(struct lan865x_priv* priv) {
+    if (!priv->plca_burst_active)
+        return;
+
+    if (lan865x_set_plca_burst(priv, false))
+        netdev_warn(priv->netdev, "Failed to disable PLCA burst\n");
+
+    priv->plca_burst_active = false;
+    priv->plca_burst_stats.active_ms += jiffies_to_msecs(jiffies - priv->plca_burst_start);
+}
+
+static void lan865x_plca_burst_work_handler(struct work_struct* work) {
+    struct lan865x_priv* priv = container_of(to_delayed_work(work), struct lan865x_priv, plca_burst_work);
+    unsigned long tx_packets = READ_ONCE(priv->netdev->stats.tx_packets);
+    u32 backlog = oa_tc6_get_tx_backlog(priv->tc6);
+
+    if (priv->plca_burst_active)
+        priv->plca_burst_stats.tx_packets += tx_packets - priv->plca_burst_tx_packets;
+    priv->plca_burst_tx_packets = tx_packets;
+
+    if (!priv->plca_burst_active) {
+        if (backlog >= LAN865X_PLCA_BURST_BACKLOG_HIGH && !lan865x_set_plca_burst(priv, true)) {
+            priv->plca_burst_active = true;
+            priv->plca_burst_idle_polls = 0;
+            priv->plca_burst_start = jiffies;
+            priv->plca_burst_stats.enabled++;
+        }
+    } else if (backlog) {
+        priv->plca_burst_idle_polls = 0;
+    } else if (++priv->plca_burst_idle_polls >= LAN865X_PLCA_BURST_IDLE_POLLS) {
+        lan865x_plca_burst_stop(priv);
+    }
+
+    schedule_delayed_work(&priv->plca_burst_work, LAN865X_PLCA_BURST_POLL_INTERVAL);
+}
+
+static void lan865x_plca_auto_burst_start(struct lan865x_priv* priv) {
+    priv->plca_burst_tx_packets = READ_ONCE(priv->netdev->stats.tx_packets);
+    schedule_delayed_work(&priv->plca_burst_work, 0);
+}
+
+static void lan865x_plca_auto_burst_stop(struct lan865x_priv* priv) {
+    cancel_delayed_work_sync(&priv->plca_burst_work);
+    lan865x_plca_burst_stop(priv);
+}
+
 static int lan865x_set_hw_macaddr_low_bytes(struct oa_tc6* tc6, const u8* mac) {
     u32 regval;
 
@@ -115,10 +201,120 @@ static int lan865x_ethtool_get_ts_info(struct net_device* netdev, struct ethtool
     return 0;
 }
 
+static void lan865x_ethtool_get_ringparam(struct net_device* netdev, struct ethtool_ringparam* ring,
+                                         struct kernel_ethtool_ringparam* kernel_ring,
+                                         struct netlink_ext_ack* extack) {
+    struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
+
+    oa_tc6_get_tx_ring_param(priv->tc6, &ring->tx_pending, &ring->tx_max_pending);
+}
+
+static int lan865x_ethtool_set_ringparam(struct net_device* netdev, struct ethtool_ringparam* ring,
+                                        struct kernel_ethtool_ringparam* kernel_ring,
+                                        struct netlink_ext_ack* extack) {
+    struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
+
+    /* Only the tx ring is configurable, rx frames are delivered as they arrive */
+    if (ring->rx_pending || ring->rx_mini_pending || ring->rx_jumbo_pending) {
+        NL_SET_ERR_MSG(extack, "Only the tx ring size can be configured");
+        return -EINVAL;
+    }
+
+    return oa_tc6_set_tx_ring_size(priv->tc6, ring->tx_pending);
+}
+
+static const char lan865x_priv_flags_strings[][ETH_GSTRING_LEN] = {
+    "tx-cut-through",
+    "rx-cut-through",
+    "plca-auto-burst",
+};
+
+static const char lan865x_stats_strings[][ETH_GSTRING_LEN] = {
+    "plca_burst_enabled",
+    "plca_burst_active_ms",
+    "plca_burst_tx_packets",
+};
+
+static int lan865x_ethtool_get_sset_count(struct net_device* netdev, int sset) {
+    switch (sset) {
+    case ETH_SS_STATS:
+        return ARRAY_SIZE(lan865x_stats_strings);
+    case ETH_SS_PRIV_FLAGS:
+        return ARRAY_SIZE(lan865x_priv_flags_strings);
+    default:
+        return -EOPNOTSUPP;
+    }
+}
+
+static void lan865x_ethtool_get_strings(struct net_device* netdev, u32 sset, u8* data) {
+    switch (sset) {
+    case ETH_SS_STATS:
+        memcpy(data, lan865x_stats_strings, sizeof(lan865x_stats_strings));
+        break;
+    case ETH_SS_PRIV_FLAGS:
+        memcpy(data, lan865x_priv_flags_strings, sizeof(lan865x_priv_flags_strings));
+        break;
+    }
+}
+
+static void lan865x_ethtool_get_stats(struct net_device* netdev, struct ethtool_stats* stats, u64* data) {
+    struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
+    u64 active_ms = priv->plca_burst_stats.active_ms;
+
+    /* Include the ongoing burst period */
+    if (priv->plca_burst_active)
+        active_ms += jiffies_to_msecs(jiffies - priv->plca_burst_start);
+
+    data[0] = priv->plca_burst_stats.enabled;
+    data[1] = active_ms;
+    data[2] = priv->plca_burst_stats.tx_packets;
+}
+
+static u32 lan865x_ethtool_get_priv_flags(struct net_device* netdev) {
+    struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
+
+    return priv->priv_flags;
+}
+
+static int lan865x_ethtool_set_priv_flags(struct net_device* netdev, u32 flags) {
+    struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
+    u32 cut_through = LAN865X_PRIV_FLAG_TX_CUT_THROUGH | LAN865X_PRIV_FLAG_RX_CUT_THROUGH;
+    int ret;
+
+    if ((flags ^ priv->priv_flags) & cut_through) {
+        /* The MAC must not be transmitting or receiving while the mode changes */
+        if (netif_running(netdev))
+            return -EBUSY;
+
+        ret = oa_tc6_set_cut_through(priv->tc6, flags & LAN865X_PRIV_FLAG_TX_CUT_THROUGH,
+                                     flags & LAN865X_PRIV_FLAG_RX_CUT_THROUGH);
+        if (ret)
+            return ret;
+    }
+
+    if (((flags ^ priv->priv_flags) & LAN865X_PRIV_FLAG_PLCA_AUTO_BURST) && netif_running(netdev)) {
+        if (flags & LAN865X_PRIV_FLAG_PLCA_AUTO_BURST)
+            lan865x_plca_auto_burst_start(priv);
+        else
+            lan865x_plca_auto_burst_stop(priv);
+    }
+
+    priv->priv_flags = flags;
+
+    return 0;
+}
+
 static const struct ethtool_ops lan865x_ethtool_ops = {
     .get_link_ksettings = phy_ethtool_get_link_ksettings,
     .set_link_ksettings = phy_ethtool_set_link_ksettings,
     .get_ts_info = lan865x_ethtool_get_ts_info,
+    .get_ringparam = lan865x_ethtool_get_ringparam,
+    .set_ringparam = lan865x_ethtool_set_ringparam,
+    .get_sset_count = lan865x_ethtool_get_sset_count,
+    .get_strings = lan865x_ethtool_get_strings,
+    .get_ethtool_stats = lan865x_ethtool_get_stats,
+    .get_priv_flags = lan865x_ethtool_get_priv_flags,
+    .set_priv_flags = lan865x_ethtool_set_priv_flags,
 };
 
 static int lan865x_get_ts_config(struct net_device* netdev, struct ifreq* ifr) {
@@ -130,9 +326,59 @@ static int lan865x_get_ts_config(struct net_device* netdev, struct ifreq* ifr) {
 
 static int lan865x_set_ts_config(struct net_device* netdev, struct ifreq* ifr) {
     struct lan865x_priv* priv = (struct lan865x_priv*)netdev_priv(netdev);
-    struct hwtstamp_config* hwts_config = &priv->tstamp_config;
+    struct hwtstamp_config hwts_config;
+    int ret;
+
+    if (copy_from_user(&hwts_config, ifr->ifr_data, sizeof(hwts_config)))
+        return -EFAULT;
+
+    if (hwts_config.flags)
+        return -EINVAL;
 
-    return copy_from_user(hwts_config, ifr->ifr_data, sizeof(*hwts_config)) ? -EFAULT : 0;
+    switch (hwts_config.tx_type) {
+    case HWTSTAMP_TX_OFF:
+    case HWTSTAMP_TX_ON:
+        break;
+    default:
+        return -ERANGE;
+    }
+
+    /* The MAC-PHY timestamps every received frame, filters it can't match
+     * exactly are rounded up to all frames.
+     */
+    switch (hwts_config.rx_filter) {
+    case HWTSTAMP_FILTER_NONE:
+    case HWTSTAMP_FILTER_ALL:
+    case HWTSTAMP_FILTER_PTP_V2_L2_EVENT:
+    case HWTSTAMP_FILTER_PTP_V2_L2_SYNC:
+    case HWTSTAMP_FILTER_PTP_V2_L2_DELAY_REQ:
+        break;
+    case HWTSTAMP_FILTER_SOME:
+    case HWTSTAMP_FILTER_PTP_V1_L4_EVENT:
+    case HWTSTAMP_FILTER_PTP_V1_L4_SYNC:
+    case HWTSTAMP_FILTER_PTP_V1_L4_DELAY_REQ:
+    case HWTSTAMP_FILTER_PTP_V2_L4_EVENT:
+    case HWTSTAMP_FILTER_PTP_V2_L4_SYNC:
+    case HWTSTAMP_FILTER_PTP_V2_L4_DELAY_REQ:
+    case HWTSTAMP_FILTER_PTP_V2_EVENT:
+    case HWTSTAMP_FILTER_PTP_V2_SYNC:
+    case HWTSTAMP_FILTER_PTP_V2_DELAY_REQ:
+    case HWTSTAMP_FILTER_NTP_ALL:
+        hwts_config.rx_filter = HWTSTAMP_FILTER_ALL;
+        break;
+    default:
+        return -ERANGE;
+    }
+
+    /* Don't spend SPI bandwidth on rx timestamps nobody asked for */
+    ret = oa_tc6_set_rx_timestamp(priv->tc6, hwts_config.rx_filter != HWTSTAMP_FILTER_NONE);
+    if (ret)
+        return ret;
+
+    oa_tc6_set_rx_ts_filter(priv->tc6, hwts_config.rx_filter);
+    priv->tstamp_config = hwts_config;
+
+    return copy_to_user(ifr->ifr_data, &hwts_config, sizeof(hwts_config)) ? -EFAULT : 0;
 }
 
 static int lan865x_set_mac_address(struct net_device* netdev, void* addr) {
@@ -312,38 +558,27 @@ static netdev_tx_t lan865x_send_packet(struct sk_buff* skb, struct net_device* n
     struct lan865x_priv* priv = netdev_priv(netdev);
     struct hwtstamp_config hwts_config = priv->tstamp_config;
 
-    struct sk_buff* cloned_skb;
-    u8 ts_capture_mode;
+    u8 ts_capture_mode = LAN865X_TIMESTAMP_ID_NONE;
+    netdev_tx_t ret;
 
-    if (skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP) {
+    if ((skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP) && hwts_config.tx_type == HWTSTAMP_TX_ON) {
+        ts_capture_mode = lan865x_ptp_txts_request(priv, skb);
+    }
 
-        cloned_skb = skb_clone(skb, GFP_ATOMIC);
-        if (!cloned_skb) {
-            netdev_err(netdev, "%s: skb_clone() failed\n", __func__);
-            return -EAGAIN;
-        }
+    ret = oa_tc6_start_xmit(priv->tc6, skb, ts_capture_mode);
 
-        /* NOTE:
-         *	skb_clone() does not copy the user-space socket (sk) information.
-         *	However, TX timestamping requires a valid sk to queue the timestamp to the user socket.
-         *	Therefore, we manually copy the sk pointer from the original skb. */
-        cloned_skb->sk = skb->sk;
-
-        if (hwts_config.tx_type != HWTSTAMP_TX_ON) {
-            ts_capture_mode = LAN865X_TIMESTAMP_ID_NONE;
-            kfree_skb(cloned_skb);
-        } else if (is_gptp_packet(skb)) {
-            ts_capture_mode = LAN865X_TIMESTAMP_ID_GPTP;
-            priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_GPTP] = skb_get(cloned_skb);
-            skb_shinfo(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_GPTP])->tx_flags |= SKBTX_IN_PROGRESS;
-        } else {
-            ts_capture_mode = LAN865X_TIMESTAMP_ID_NORMAL;
-            priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_NORMAL] = skb_get(cloned_skb);
-            skb_shinfo(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_NORMAL])->tx_flags |= SKBTX_IN_PROGRESS;
-        }
+    /* The frame is not sent now: either the stack sends it again and it
+     * requests a capture register again then, or it was dropped.
+     */
+    if (ret != NETDEV_TX_OK && ts_capture_mode != LAN865X_TIMESTAMP_ID_NONE) {
+        lan865x_ptp_txts_cancel(priv, ts_capture_mode);
+    }
+
+    if (ret == NET_XMIT_DROP) {
+        return NETDEV_TX_OK;
     }
 
-    return oa_tc6_start_xmit(priv->tc6, skb, ts_capture_mode);
+    return ret;
 }
 
 static int lan865x_hw_disable(struct lan865x_priv* priv) {
@@ -367,6 +602,8 @@ static int lan865x_net_close(struct net_device* netdev) {
     int ret;
 
     netif_stop_queue(netdev);
+    if (priv->priv_flags & LAN865X_PRIV_FLAG_PLCA_AUTO_BURST)
+        lan865x_plca_auto_burst_stop(priv);
     phy_stop(netdev->phydev);
     ret = lan865x_hw_disable(priv);
     if (ret) {
@@ -405,6 +642,9 @@ static int lan865x_net_open(struct net_device* netdev) {
 
     phy_start(netdev->phydev);
 
+    if (priv->priv_flags & LAN865X_PRIV_FLAG_PLCA_AUTO_BURST)
+        lan865x_plca_auto_burst_start(priv);
+
     return 0;
 }
 
@@ -468,6 +708,8 @@ static int lan865x_probe(struct spi_device* spi) {
     priv->spi = spi;
     spi_set_drvdata(spi, priv);
     INIT_WORK(&priv->multicast_work, lan865x_multicast_work_handler);
+    INIT_DELAYED_WORK(&priv->plca_burst_work, lan865x_plca_burst_work_handler);
+    spin_lock_init(&priv->txts_lock);
 
     // TODO: lan865x register init
     // ref: oa_tc6.c -> init_lan865x()
@@ -568,7 +810,9 @@ static void lan865x_remove(struct spi_device* spi) {
     struct lan865x_priv* priv = spi_get_drvdata(spi);
 
     cancel_work_sync(&priv->multicast_work);
+    ptp_device_destroy(priv->ptpdev);
     unregister_netdev(priv->netdev);
+    lan865x_ptp_txts_purge(priv);
     oa_tc6_exit(priv->tc6);
     free_netdev(priv->netdev);
     misc_deregister(&lan865x_miscdev);
@@ -650,7 +894,27 @@ static struct spi_driver lan865x_driver = {
     .remove = lan865x_remove,
     .id_table = spidev_spi_ids,
 };
-module_spi_driver(lan865x_driver);
+
+static int __init lan865x_driver_init(void) {
+    int ret;
+
+    ret = lan865x_phy_register();
+    if (ret)
+        return ret;
+
+    ret = spi_register_driver(&lan865x_driver);
+    if (ret)
+        lan865x_phy_unregister();
+
+    return ret;
+}
+module_init(lan865x_driver_init);
+
+static void __exit lan865x_driver_exit(void) {
+    spi_unregister_driver(&lan865x_driver);
+    lan865x_phy_unregister();
+}
+module_exit(lan865x_driver_exit);
 
 MODULE_DESCRIPTION(DRV_NAME " 10Base-T1S MACPHY Ethernet Driver");
 MODULE_AUTHOR("Parthiban Veerasooran <parthiban.veerasooran@microchip.com>");
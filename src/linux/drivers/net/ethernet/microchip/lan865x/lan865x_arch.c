@@ -10,28 +10,46 @@ void write32(u32 val, void* addr) {
     iowrite32(val, addr);
 }
 
-sysclock_t lan865x_get_sys_clock(struct lan865x_priv* priv) {
+/* A TN below this may have been read after the seconds rolled over */
+#define MAC_TN_ROLLOVER_GUARD_NS 1000000
+
+sysclock_t lan865x_get_sys_clock_sts(struct lan865x_priv* priv, struct ptp_system_timestamp* sts) {
     struct oa_tc6* tc6 = priv->tc6;
 
-    u32 sec_h;
+    u32 ts[2]; /* MAC_TSL, MAC_TN */
     u32 sec, nsec;
     u64 tmp_sec, clock;
 
-    if (oa_tc6_read_register(tc6, MMS1_MAC_TN, &nsec))
-        return -ENODEV;
-    if (oa_tc6_read_register(tc6, MMS1_MAC_TSL, &sec))
-        return -ENODEV;
-    if (oa_tc6_read_register(tc6, MMS1_MAC_TSH, &sec_h))
+    /* MAC_TSL and MAC_TN are adjacent, read both in one control command and
+     * take the system time right around that single transfer.
+     */
+    ptp_read_system_prets(sts);
+    if (oa_tc6_read_registers(tc6, MMS1_MAC_TSL, ts, ARRAY_SIZE(ts)))
         return -ENODEV;
+    ptp_read_system_postts(sts);
+
+    sec = ts[0];
+    nsec = ts[1] & 0x3FFFFFFF;
+
+    /* MAC_TSL is read before MAC_TN. If the seconds rolled over in between,
+     * MAC_TN belongs to the next second, so read MAC_TSL again.
+     */
+    if (nsec < MAC_TN_ROLLOVER_GUARD_NS) {
+        if (oa_tc6_read_register(tc6, MMS1_MAC_TSL, &sec))
+            return -ENODEV;
+    }
 
     tmp_sec = (u64)sec * NS_IN_1S;
-    nsec = nsec & 0x3FFFFFFF;
 
     clock = tmp_sec + nsec;
 
     return clock;
 }
 
+sysclock_t lan865x_get_sys_clock(struct lan865x_priv* priv) {
+    return lan865x_get_sys_clock_sts(priv, NULL);
+}
+
 int lan865x_set_sys_clock(struct lan865x_priv* priv, u64 timestamp) {
     struct oa_tc6* tc6 = priv->tc6;
 
@@ -75,39 +93,43 @@ void lan865x_set_sys_clock_ti(struct lan865x_priv* priv, u64 subnano_b24) {
     oa_tc6_write_register(tc6, MMS1_MAC_TISUBN, reg_tisubn_val);
 }
 
-void lan865x_add_sys_clock(struct lan865x_priv* priv, u32 add_offset) {
+int lan865x_add_sys_clock(struct lan865x_priv* priv, u32 add_offset) {
     struct oa_tc6* tc6 = priv->tc6;
     u32 reg_val = 0;
 
-    add_offset = (add_offset >> 2); // 32bit -> 30bit
+    if (add_offset > MAC_TA_ITDT_MAX)
+        return -ERANGE;
 
     /* Bits 29:0 = ITDT */
-    reg_val |= (add_offset & 0x3FFFFFFF);
+    reg_val |= (add_offset & MAC_TA_ITDT_MAX);
 
     /* Bit 31 = 0 (add) */
-    reg_val &= ~(1U << 31);
+    reg_val &= ~MAC_TA_ADJ;
 
     /* Set MAC_TA(TSU Timer Adjust) register */
-    oa_tc6_write_register(tc6, MMS1_MAC_TA, reg_val);
+    return oa_tc6_write_register(tc6, MMS1_MAC_TA, reg_val);
 }
 
-void lan865x_sub_sys_clock(struct lan865x_priv* priv, u32 sub_offset) {
+int lan865x_sub_sys_clock(struct lan865x_priv* priv, u32 sub_offset) {
     struct oa_tc6* tc6 = priv->tc6;
     u32 reg_val = 0;
 
+    if (sub_offset > MAC_TA_ITDT_MAX)
+        return -ERANGE;
+
     /* Bits 29:0 = ITDT */
-    reg_val |= (sub_offset & 0x3FFFFFFF);
+    reg_val |= (sub_offset & MAC_TA_ITDT_MAX);
 
     /* Bit 31 = 1 (subtract) */
-    reg_val |= (1U << 31);
+    reg_val |= MAC_TA_ADJ;
 
     /* Set MAC_TA(TSU Timer Adjust) register */
-    oa_tc6_write_register(tc6, MMS1_MAC_TA, reg_val);
+    return oa_tc6_write_register(tc6, MMS1_MAC_TA, reg_val);
 }
 
 timestamp_t lan865x_read_tx_timestamp(struct lan865x_priv* priv, int tx_id) {
     struct oa_tc6* tc6 = priv->tc6;
-    u32 ts_h = 0, ts_l = 0;
+    u32 ts[2] = {0};
     u64 tmp_sec = 0;
     u64 timestamp = 0;
 
@@ -116,22 +138,16 @@ timestamp_t lan865x_read_tx_timestamp(struct lan865x_priv* priv, int tx_id) {
         [LAN865X_TIMESTAMP_ID_NORMAL]  = MMS0_TTSCBH,
         [LAN865X_TIMESTAMP_ID_RESERVED]= MMS0_TTSCCH,
     };
-    static const u16 reg_lo[] = {
-        [LAN865X_TIMESTAMP_ID_GPTP]    = MMS0_TTSCAL,
-        [LAN865X_TIMESTAMP_ID_NORMAL]  = MMS0_TTSCBL,
-        [LAN865X_TIMESTAMP_ID_RESERVED]= MMS0_TTSCCL,
-    };
 
-    if (tx_id < 0 || tx_id >= ARRAY_SIZE(reg_hi) || !reg_hi[tx_id] || !reg_lo[tx_id])
+    if (tx_id < 0 || tx_id >= ARRAY_SIZE(reg_hi) || !reg_hi[tx_id])
         return -EINVAL;
 
-    oa_tc6_read_register(tc6, reg_hi[tx_id], &ts_h);
-    oa_tc6_read_register(tc6, reg_lo[tx_id], &ts_l);
+    /* TTSCxH and TTSCxL are adjacent, read both in one control command */
+    oa_tc6_read_registers(tc6, reg_hi[tx_id], ts, ARRAY_SIZE(ts));
 
-    tmp_sec = (u64)ts_h * NS_IN_1S;
-    ts_l = ts_l & 0xFFFFFFFF;
+    tmp_sec = (u64)ts[0] * NS_IN_1S;
 
-    timestamp = tmp_sec + ts_l;
+    timestamp = tmp_sec + ts[1];
     return timestamp;
 }
 
@@ -5,6 +5,7 @@
 #include <linux/oa_tc6.h>
 #include <linux/pci.h>
 #include <linux/ptp_clock_kernel.h>
+#include <linux/timecounter.h>
 #include <linux/types.h>
 #include <net/pkt_sched.h>
 
@@ -22,6 +23,8 @@
 #define MMS1_MAC_TSL 0x00010074
 #define MMS1_MAC_TN 0x00010075
 #define MMS1_MAC_TA 0x00010076
+#define MAC_TA_ADJ (1U << 31)       // 1: subtract ITDT, 0: add ITDT
+#define MAC_TA_ITDT_MAX 0x3FFFFFFF // ITDT, bits 29:0 (ns)
 #define MMS1_MAC_TI 0x00010077
 #define MMS1_MAC_TISUBN 0x0001006F
 #define TISUBNS_FRAC_BITS 24
@@ -40,7 +43,12 @@
 #define TS_B_MASK (1 << 9)
 #define TS_C_MASK (1 << 10)
 
-#define MMS0_OA_MASK0 0x00000013
+#define MMS0_OA_STATUS1 0x00000009
+#define TS_A_MISSED_MASK (1 << 24)
+#define TS_B_MISSED_MASK (1 << 25)
+#define TS_C_MISSED_MASK (1 << 26)
+
+#define MMS0_OA_MASK0 0x0000000C
 #define TS_A_INT_MASK (1 << 8)
 #define TS_B_INT_MASK (1 << 9)
 #define TS_C_INT_MASK (1 << 10)
@@ -55,6 +63,11 @@ enum lan865x_timestamp_id {
 
 #define NS_IN_1S 1000000000
 
+/* A capture register holds one timestamp, so only one frame at a time waits
+ * for each. A frame whose capture didn't arrive in time is dropped.
+ */
+#define LAN865X_TXTS_TIMEOUT (HZ / 2)
+
 /* 25Mhz = LAN8650 SPI MAX Hz */
 #define TICKS_SCALE 40
 #define RESERVED_CYCLE 25000000
@@ -68,12 +81,28 @@ struct ptp_device {
     struct ptp_clock* ptp_clock;
     struct ptp_clock_info ptp_info;
 
-    struct task_struct* ptp_thread;
+    unsigned long pending_ttsc;        // TS_x_MASK bits whose capture register has not been read yet
+    unsigned long pending_ttsc_missed; // TS_x_MISSED_MASK bits not handled yet
 
     u32 ti_subnano_b24; // timer increase every clock (25MHz) cycle
     u64 offset;
 
-    spinlock_t lock;
+    struct mutex lock; // serializes the hardware clock accesses
+
+    /* Software clock extrapolated from the last hardware clock sample */
+    spinlock_t tc_lock;
+    struct cyclecounter cc;
+    struct timecounter tc;
+    u64 tc_last_raw_ns;
+    u64 tc_last_hw_ns;
+    bool tc_rate_valid;
+    unsigned long tc_next_resample;
+};
+
+struct lan865x_plca_burst_stats {
+    u64 enabled;    // Times bursting was enabled for a tx backlog
+    u64 active_ms;  // Time spent with bursting enabled
+    u64 tx_packets; // Frames sent while bursting was enabled
 };
 
 struct lan865x_priv {
@@ -84,10 +113,24 @@ struct lan865x_priv {
 
     struct ptp_device* ptpdev;
     struct hwtstamp_config tstamp_config;
-    struct sk_buff* waiting_txts_skb[LAN865X_TIMESTAMP_ID_MAX - 1];
+    spinlock_t txts_lock;                           // Protects txts_skb
+    struct sk_buff* txts_skb[LAN865X_TIMESTAMP_ID_MAX]; // skb clone waiting for each capture register
+    u32 txts_skipped;  // Frames sent without capture, all capture registers were busy
+    u32 txts_timeouts; // Pending skbs whose capture did not arrive
+    u32 txts_missed;   // Pending skbs whose capture the MAC-PHY reported as missed
 
     uint64_t total_tx_count;
     uint64_t total_tx_drop_count;
+
+    u32 priv_flags; // LAN865X_PRIV_FLAG_* set through ethtool
+
+    /* PLCA auto burst, driven by the tx backlog */
+    struct delayed_work plca_burst_work;
+    bool plca_burst_active;
+    u8 plca_burst_idle_polls;
+    unsigned long plca_burst_start;      // jiffies when bursting was enabled
+    unsigned long plca_burst_tx_packets; // tx_packets at the previous poll
+    struct lan865x_plca_burst_stats plca_burst_stats;
 };
 
 struct lan865x_priv* get_lan865x_priv_by_ptp_info(struct ptp_clock_info* ptp_info);
@@ -96,11 +139,12 @@ uint32_t read32(void* addr);
 void write32(uint32_t val, void* addr);
 
 sysclock_t lan865x_get_sys_clock(struct lan865x_priv* priv);
+sysclock_t lan865x_get_sys_clock_sts(struct lan865x_priv* priv, struct ptp_system_timestamp* sts);
 int lan865x_set_sys_clock(struct lan865x_priv* priv, u64 timestamp);
 u32 lan865x_get_cycle_1s(void);
 void lan865x_set_sys_clock_ti(struct lan865x_priv* priv, u64 subnano_b24);
-void lan865x_add_sys_clock(struct lan865x_priv* priv, u32 add_offset);
-void lan865x_sub_sys_clock(struct lan865x_priv* priv, u32 sub_offset);
+int lan865x_add_sys_clock(struct lan865x_priv* priv, u32 add_offset);
+int lan865x_sub_sys_clock(struct lan865x_priv* priv, u32 sub_offset);
 timestamp_t lan865x_read_tx_timestamp(struct lan865x_priv* priv, int tx_id);
 u64 lan865x_get_tx_packets(struct lan865x_priv* priv);
 u64 lan865x_get_tx_drop_packets(struct lan865x_priv* priv);
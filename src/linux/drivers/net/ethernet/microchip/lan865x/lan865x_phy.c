@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Driver for the internal 10BASE-T1S PHY of the LAN865x MAC-PHY
+ *
+ * The PHY is reached through the oa_tc6 MDIO bus. It gives ethtool access to
+ * the PLCA configuration and status (ethtool --get-plca-cfg, --set-plca-cfg,
+ * --get-plca-status), which are the standard Open Alliance TC14 registers in
+ * MMS 4.
+ */
+
+#include "lan865x_phy.h"
+
+#include <linux/mdio.h>
+#include <linux/phy.h>
+
+#define PHY_ID_LAN865X 0x0007C1B0 /* Rev.B0 is 0x0007C1B3 */
+
+/* The oa_tc6 MDIO bus maps the C45 MMDs onto the MAC-PHY memory map
+ * selectors. Access them directly instead of through the C22 MMD indirect
+ * registers, which would take three more SPI control transactions.
+ */
+static int lan865x_phy_read_mmd(struct phy_device* phydev, int devnum, u16 regnum) {
+    return __mdiobus_c45_read(phydev->mdio.bus, phydev->mdio.addr, devnum, regnum);
+}
+
+static int lan865x_phy_write_mmd(struct phy_device* phydev, int devnum, u16 regnum, u16 val) {
+    return __mdiobus_c45_write(phydev->mdio.bus, phydev->mdio.addr, devnum, regnum, val);
+}
+
+/* A 10BASE-T1S multidrop segment has no link negotiation, the link is always
+ * up at 10 Mbit/s half duplex.
+ */
+static int lan865x_phy_read_status(struct phy_device* phydev) {
+    phydev->link = 1;
+    phydev->speed = SPEED_10;
+    phydev->duplex = DUPLEX_HALF;
+    phydev->autoneg = AUTONEG_DISABLE;
+    phydev->pause = 0;
+    phydev->asym_pause = 0;
+
+    return 0;
+}
+
+static struct phy_driver lan865x_phy_driver[] = {
+    {
+        PHY_ID_MATCH_MODEL(PHY_ID_LAN865X),
+        .name = "LAN865x Internal PHY",
+        .features = PHY_BASIC_T1S_P2MP_FEATURES,
+        .read_status = lan865x_phy_read_status,
+        .read_mmd = lan865x_phy_read_mmd,
+        .write_mmd = lan865x_phy_write_mmd,
+        .get_plca_cfg = genphy_c45_plca_get_cfg,
+        .set_plca_cfg = genphy_c45_plca_set_cfg,
+        .get_plca_status = genphy_c45_plca_get_status,
+    },
+};
+
+/* Registered before the SPI driver so the PHY found on the oa_tc6 MDIO bus
+ * binds to it instead of the generic PHY driver.
+ */
+int lan865x_phy_register(void) {
+    return phy_drivers_register(lan865x_phy_driver, ARRAY_SIZE(lan865x_phy_driver), THIS_MODULE);
+}
+
+void lan865x_phy_unregister(void) {
+    phy_drivers_unregister(lan865x_phy_driver, ARRAY_SIZE(lan865x_phy_driver));
+}
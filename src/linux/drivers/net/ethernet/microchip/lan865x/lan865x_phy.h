@@ -0,0 +1,7 @@
+#ifndef LAN865X_PHY_H
+#define LAN865X_PHY_H
+
+int lan865x_phy_register(void);
+void lan865x_phy_unregister(void);
+
+#endif /* LAN865X_PHY_H */
@@ -3,12 +3,18 @@
 #include <linux/if_ether.h>
 #include <linux/if_vlan.h>
 
-#include <linux/delay.h>
-
 #define NSEC_PER_MHZ 1000
 #define MHZ_TO_NS(mhz) (NSEC_PER_MHZ / (mhz))
 
-#define PTP_THREAD_INTERVAL_MICROSECOND 10
+/* The timecounter counts CLOCK_MONOTONIC_RAW ns, scaled to PHC ns by mult */
+#define PTP_TC_SHIFT 28
+#define PTP_TC_RESAMPLE_INTERVAL (HZ / 10)
+/* Limit for the measured rate against the rate programmed in MAC_TI */
+#define PTP_TC_MAX_RATE_ERROR_PPM 500
+
+static bool hw_gettime;
+module_param(hw_gettime, bool, 0644);
+MODULE_PARM_DESC(hw_gettime, "Read the hardware clock on every gettime instead of extrapolating the last sample");
 
 struct lan865x_priv* get_lan865x_priv_by_ptp_info(struct ptp_clock_info* ptp_info) {
     struct ptp_device* ptpdev = container_of(ptp_info, struct ptp_device, ptp_info);
@@ -17,52 +23,272 @@ struct lan865x_priv* get_lan865x_priv_by_ptp_info(struct ptp_clock_info* ptp_inf
     return priv;
 }
 
-static int lan865x_ptp_thread_handler(void* data) {
-    struct ptp_device* ptpdev = (struct ptp_device*)data;
-    struct lan865x_priv* priv = dev_get_drvdata(ptpdev->dev);
-    u32 status;
-    timestamp_t tx_ts;
-    struct skb_shared_hwtstamps skb_hwts;
+struct lan865x_txts_cb {
+    unsigned long queued; // jiffies
+};
 
-    while (true) {
-        // NOTE: ptp_thread_handler operates at 10µs intervals, which may affect PTP accuracy.
-        udelay(PTP_THREAD_INTERVAL_MICROSECOND);
+#define LAN865X_TXTS_CB(skb) ((struct lan865x_txts_cb*)(skb)->cb)
 
-        oa_tc6_read_register(ptpdev->tc6, MMS0_OA_STATUS0, &status);
+static struct sk_buff* lan865x_ptp_txts_take(struct lan865x_priv* priv, u8 tx_id) {
+    struct sk_buff* skb;
+    unsigned long flags;
 
-        // GPTP
-        if (status & TS_A_MASK) {
-            tx_ts = lan865x_read_tx_timestamp(priv, 1);
-            LAN865X_DEBUG("%s: A Timestamp = %llu.%llu\n", __func__, tx_ts / NS_IN_1S, tx_ts % NS_IN_1S);
+    spin_lock_irqsave(&priv->txts_lock, flags);
+    skb = priv->txts_skb[tx_id];
+    priv->txts_skb[tx_id] = NULL;
+    spin_unlock_irqrestore(&priv->txts_lock, flags);
 
-            skb_hwts.hwtstamp = ns_to_ktime(tx_ts);
-            LAN865X_DEBUG("%s: tx_ts = %llu, skb_hwts.hwtstamp = %llu\n", __func__, tx_ts, skb_hwts.hwtstamp);
-            skb_tstamp_tx(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_GPTP], &skb_hwts);
-            kfree_skb(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_GPTP]);
-        }
-        // NORMAL
-        if (status & TS_B_MASK) {
-            tx_ts = lan865x_read_tx_timestamp(priv, 2);
-            LAN865X_DEBUG("%s: B Timestamp = %llu.%llu\n", __func__, tx_ts / NS_IN_1S, tx_ts % NS_IN_1S);
-
-            skb_hwts.hwtstamp = ns_to_ktime(tx_ts);
-            LAN865X_DEBUG("%s: tx_ts = %llu, skb_hwts.hwtstamp = %llu\n", __func__, tx_ts, skb_hwts.hwtstamp);
-            skb_tstamp_tx(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_NORMAL], &skb_hwts);
-            kfree_skb(priv->waiting_txts_skb[LAN865X_TIMESTAMP_ID_NORMAL]);
-        }
-        // RESERVED
-        if (status & TS_C_MASK) {
-            tx_ts = lan865x_read_tx_timestamp(priv, 3);
-            LAN865X_DEBUG("%s: C Timestamp = %llu.%llu\n", __func__, tx_ts / NS_IN_1S, tx_ts % NS_IN_1S);
+    return skb;
+}
+
+/* Drops the pending skbs whose capture should have arrived long ago, so their
+ * capture registers can be used again.
+ */
+static void lan865x_ptp_txts_expire(struct lan865x_priv* priv) {
+    for (u8 tx_id = LAN865X_TIMESTAMP_ID_GPTP; tx_id < LAN865X_TIMESTAMP_ID_MAX; tx_id++) {
+        struct sk_buff* skb;
+        unsigned long flags;
+
+        spin_lock_irqsave(&priv->txts_lock, flags);
+        skb = priv->txts_skb[tx_id];
+        if (skb && time_after(jiffies, LAN865X_TXTS_CB(skb)->queued + LAN865X_TXTS_TIMEOUT))
+            priv->txts_skb[tx_id] = NULL;
+        else
+            skb = NULL;
+        spin_unlock_irqrestore(&priv->txts_lock, flags);
+
+        if (skb) {
+            LAN865X_DEBUG("%s: tx timestamp timed out\n", __func__);
+            WRITE_ONCE(priv->txts_timeouts, priv->txts_timeouts + 1);
+            kfree_skb(skb);
         }
+    }
+}
+
+static void lan865x_ptp_deliver_tx_timestamp(struct lan865x_priv* priv, int tx_id) {
+    struct skb_shared_hwtstamps skb_hwts;
+    struct sk_buff* skb;
+    timestamp_t tx_ts;
+
+    tx_ts = lan865x_read_tx_timestamp(priv, tx_id);
+    LAN865X_DEBUG("%s: %d Timestamp = %llu.%llu\n", __func__, tx_id, tx_ts / NS_IN_1S, tx_ts % NS_IN_1S);
+
+    /* Only one frame waits for each capture register, so the capture is
+     * always its own.
+     */
+    skb = lan865x_ptp_txts_take(priv, tx_id);
+    if (!skb)
+        return;
+
+    skb_hwts.hwtstamp = ns_to_ktime(tx_ts);
+    skb_tstamp_tx(skb, &skb_hwts);
+    kfree_skb(skb);
+}
+
+/* The MAC-PHY reported that the frame waiting for the capture register was
+ * not captured, drop it right away instead of waiting for the timeout.
+ */
+static void lan865x_ptp_drop_tx_timestamp(struct lan865x_priv* priv, int tx_id) {
+    struct sk_buff* skb = lan865x_ptp_txts_take(priv, tx_id);
+
+    if (!skb)
+        return;
+
+    LAN865X_DEBUG("%s: %d tx timestamp capture missed\n", __func__, tx_id);
+    WRITE_ONCE(priv->txts_missed, priv->txts_missed + 1);
+    kfree_skb(skb);
+}
+
+/**
+ * lan865x_ptp_txts_request - reserve a capture register for a tx timestamp.
+ * @priv: lan865x_priv struct.
+ * @skb: frame to be sent.
+ *
+ * A capture register holds a single timestamp, so it is reserved for one frame
+ * until its capture was delivered. The three registers form a pool: gPTP
+ * frames may use any of them, other frames only B and C so that they can't
+ * hold up gPTP.
+ *
+ * Return: capture register for the frame, LAN865X_TIMESTAMP_ID_NONE if no
+ * timestamp will be taken.
+ */
+u8 lan865x_ptp_txts_request(struct lan865x_priv* priv, struct sk_buff* skb) {
+    struct sk_buff* clone;
+    unsigned long flags;
+    u8 tx_id;
+
+    /* Holds a reference to the socket the timestamp is reported to */
+    clone = skb_clone_sk(skb);
+    if (!clone)
+        return LAN865X_TIMESTAMP_ID_NONE;
 
-        if (status & (TS_A_MASK | TS_B_MASK | TS_C_MASK)) {
-            oa_tc6_write_register(ptpdev->tc6, MMS0_OA_STATUS0, status);
+    LAN865X_TXTS_CB(clone)->queued = jiffies;
+
+    tx_id = is_gptp_packet(skb) ? LAN865X_TIMESTAMP_ID_GPTP : LAN865X_TIMESTAMP_ID_NORMAL;
+
+    spin_lock_irqsave(&priv->txts_lock, flags);
+    for (; tx_id < LAN865X_TIMESTAMP_ID_MAX; tx_id++) {
+        if (!priv->txts_skb[tx_id]) {
+            priv->txts_skb[tx_id] = clone;
+            break;
         }
-        status = 0;
     }
+    spin_unlock_irqrestore(&priv->txts_lock, flags);
 
-    return 0;
+    if (tx_id == LAN865X_TIMESTAMP_ID_MAX) {
+        WRITE_ONCE(priv->txts_skipped, priv->txts_skipped + 1);
+        kfree_skb(clone);
+        return LAN865X_TIMESTAMP_ID_NONE;
+    }
+
+    skb_shinfo(skb)->tx_flags |= SKBTX_IN_PROGRESS;
+
+    return tx_id;
+}
+
+/* The frame for which lan865x_ptp_txts_request() reserved the capture
+ * register was not sent, release the register again.
+ */
+void lan865x_ptp_txts_cancel(struct lan865x_priv* priv, u8 tx_id) {
+    struct sk_buff* skb = lan865x_ptp_txts_take(priv, tx_id);
+
+    if (skb)
+        kfree_skb(skb);
+}
+
+void lan865x_ptp_txts_purge(struct lan865x_priv* priv) {
+    for (u8 tx_id = LAN865X_TIMESTAMP_ID_GPTP; tx_id < LAN865X_TIMESTAMP_ID_MAX; tx_id++)
+        lan865x_ptp_txts_cancel(priv, tx_id);
+}
+
+static u64 lan865x_ptp_tc_read(const struct cyclecounter* cc) {
+    (void)cc;
+
+    return ktime_get_raw_ns();
+}
+
+/* mult for the rate programmed in MAC_TI, assuming the host and the MAC-PHY
+ * clocks run at the same rate.
+ */
+static u32 lan865x_ptp_tc_nominal_mult(u32 ti_subnano_b24) {
+    return div_u64((u64)ti_subnano_b24 << (PTP_TC_SHIFT - TISUBNS_FRAC_BITS), TICKS_SCALE);
+}
+
+/* Takes a new sample of the hardware clock and restarts the timecounter from
+ * it. Between two samples without clock changes in between, the rate of the
+ * PHC against the host clock is measured, which also covers the host and
+ * MAC-PHY crystals running at different frequencies. Called with ptpdev->lock
+ * held.
+ */
+static void lan865x_ptp_tc_resample(struct ptp_device* ptpdev) {
+    struct lan865x_priv* priv = dev_get_drvdata(ptpdev->dev);
+    u64 pre, post, raw_ns, hw_ns, nominal;
+    unsigned long flags;
+    u64 mult;
+
+    pre = ktime_get_raw_ns();
+    hw_ns = lan865x_get_sys_clock(priv);
+    post = ktime_get_raw_ns();
+    if ((s64)hw_ns < 0) {
+        /* Retry at the next interval instead of hammering the SPI bus from
+         * the aux worker while the MAC-PHY is unreachable.
+         */
+        WRITE_ONCE(ptpdev->tc_next_resample, jiffies + PTP_TC_RESAMPLE_INTERVAL);
+        dev_warn_ratelimited(ptpdev->dev, "Failed to read the hardware clock: %lld\n", (s64)hw_ns);
+        return;
+    }
+
+    /* The PHC was sampled somewhere in the control transaction */
+    raw_ns = pre + (post - pre) / 2;
+
+    spin_lock_irqsave(&ptpdev->tc_lock, flags);
+
+    if (ptpdev->tc_rate_valid && raw_ns > ptpdev->tc_last_raw_ns && hw_ns > ptpdev->tc_last_hw_ns) {
+        mult = div64_u64((hw_ns - ptpdev->tc_last_hw_ns) << PTP_TC_SHIFT, raw_ns - ptpdev->tc_last_raw_ns);
+        nominal = lan865x_ptp_tc_nominal_mult(ptpdev->ti_subnano_b24);
+
+        /* Ignore samples disturbed by a long delay in the control path */
+        if (abs_diff(mult, nominal) <= div_u64(nominal * PTP_TC_MAX_RATE_ERROR_PPM, 1000000))
+            ptpdev->cc.mult = mult;
+    }
+
+    ptpdev->tc.cycle_last = raw_ns;
+    ptpdev->tc.nsec = hw_ns;
+    ptpdev->tc.frac = 0;
+    ptpdev->tc_last_raw_ns = raw_ns;
+    ptpdev->tc_last_hw_ns = hw_ns;
+    ptpdev->tc_rate_valid = true;
+    ptpdev->tc_next_resample = jiffies + PTP_TC_RESAMPLE_INTERVAL;
+
+    spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+
+    /* 32-bit rx timestamps only carry the 2 LSBs of the seconds */
+    oa_tc6_set_rx_ts_reference(ptpdev->tc6, hw_ns);
+}
+
+/* The hardware clock was stepped or its rate changed, so the rate can't be
+ * measured against the previous sample. Called with ptpdev->lock held.
+ */
+static void lan865x_ptp_tc_reset(struct ptp_device* ptpdev) {
+    unsigned long flags;
+
+    spin_lock_irqsave(&ptpdev->tc_lock, flags);
+    ptpdev->tc_rate_valid = false;
+    spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+
+    lan865x_ptp_tc_resample(ptpdev);
+}
+
+static void lan865x_ptp_process_capture(struct ptp_device* ptpdev, struct lan865x_priv* priv, int tx_id, u32 ts_mask,
+                                        u32 missed_mask) {
+    bool missed = test_and_clear_bit(__ffs(missed_mask), &ptpdev->pending_ttsc_missed);
+
+    if (test_and_clear_bit(__ffs(ts_mask), &ptpdev->pending_ttsc))
+        lan865x_ptp_deliver_tx_timestamp(priv, tx_id);
+    else if (missed)
+        lan865x_ptp_drop_tx_timestamp(priv, tx_id);
+}
+
+static long lan865x_ptp_do_aux_work(struct ptp_clock_info* ptp_info) {
+    struct ptp_device* ptpdev = container_of(ptp_info, struct ptp_device, ptp_info);
+    struct lan865x_priv* priv = dev_get_drvdata(ptpdev->dev);
+
+    // GPTP
+    lan865x_ptp_process_capture(ptpdev, priv, LAN865X_TIMESTAMP_ID_GPTP, TS_A_MASK, TS_A_MISSED_MASK);
+    // NORMAL
+    lan865x_ptp_process_capture(ptpdev, priv, LAN865X_TIMESTAMP_ID_NORMAL, TS_B_MASK, TS_B_MISSED_MASK);
+    // RESERVED
+    lan865x_ptp_process_capture(ptpdev, priv, LAN865X_TIMESTAMP_ID_RESERVED, TS_C_MASK, TS_C_MISSED_MASK);
+
+    lan865x_ptp_txts_expire(priv);
+
+    /* Capture interrupts schedule the worker early, resample only when due */
+    if (time_after_eq(jiffies, READ_ONCE(ptpdev->tc_next_resample))) {
+        mutex_lock(&ptpdev->lock);
+        lan865x_ptp_tc_resample(ptpdev);
+        mutex_unlock(&ptpdev->lock);
+    }
+
+    return max_t(long, (long)(READ_ONCE(ptpdev->tc_next_resample) - jiffies), 0);
+}
+
+/* Called by oa_tc6 from the SPI thread when TTSCAx is set in STATUS0 or
+ * TTSCMx in STATUS1. The capture registers are read from the PTP worker so the
+ * SPI thread can go on with the data transfer. A register is only used again
+ * once its capture was handled, so no capture can be overwritten while it
+ * waits for the worker.
+ */
+static void lan865x_ptp_ts_capture(void* ctx, u32 ttsc_status, u32 ttsc_missed) {
+    struct ptp_device* ptpdev = ctx;
+    unsigned long status = ttsc_status & (TS_A_MASK | TS_B_MASK | TS_C_MASK);
+    unsigned long missed = ttsc_missed & (TS_A_MISSED_MASK | TS_B_MISSED_MASK | TS_C_MISSED_MASK);
+    unsigned int bit;
+
+    for_each_set_bit(bit, &status, BITS_PER_LONG)
+        set_bit(bit, &ptpdev->pending_ttsc);
+    for_each_set_bit(bit, &missed, BITS_PER_LONG)
+        set_bit(bit, &ptpdev->pending_ttsc_missed);
+    ptp_schedule_worker(ptpdev->ptp_clock, 0);
 }
 
 bool is_gptp_packet(const struct sk_buff* skb) {
@@ -85,6 +311,7 @@ bool is_gptp_packet(const struct sk_buff* skb) {
 static int lan865x_ptp_adjfine(struct ptp_clock_info* ptp_info, long scaled_ppm) {
     u64 ticks_scale, diff_b24;
     unsigned long flags;
+    u32 old_ti;
     u32 ppm;
     int is_negative = 0;
 
@@ -93,7 +320,7 @@ static int lan865x_ptp_adjfine(struct ptp_clock_info* ptp_info, long scaled_ppm)
 
     LAN865X_DEBUG("lan865x: call %s", __func__);
 
-    spin_lock_irqsave(&ptpdev->lock, flags);
+    mutex_lock(&ptpdev->lock);
 
     if (scaled_ppm == 0) {
         goto exit;
@@ -109,36 +336,74 @@ static int lan865x_ptp_adjfine(struct ptp_clock_info* ptp_info, long scaled_ppm)
     diff_b24 = mul_u64_u64_div_u64(TICKS_SCALE << (24 - 16), (u64)scaled_ppm, 1000000ULL);
     ticks_scale = ((TICKS_SCALE << 24) + (is_negative ? -diff_b24 : diff_b24));
 
+    /* Accumulate the time up to now at the old rate */
+    spin_lock_irqsave(&ptpdev->tc_lock, flags);
+    timecounter_read(&ptpdev->tc);
+    spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+
     lan865x_set_sys_clock_ti(priv, ticks_scale);
+    old_ti = ptpdev->ti_subnano_b24;
     ptpdev->ti_subnano_b24 = ticks_scale;
 
+    /* Keep the measured host clock correction, scale it to the new rate */
+    spin_lock_irqsave(&ptpdev->tc_lock, flags);
+    ptpdev->cc.mult = mul_u64_u64_div_u64(ptpdev->cc.mult, ticks_scale, old_ti);
+    ptpdev->tc_rate_valid = false;
+    spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+
     LAN865X_DEBUG("%s: scaled_ppm = %ld, diff = %llu, ticks_scale = %llu = %014llx\n", __func__, scaled_ppm, diff_b24,
                   ticks_scale, ticks_scale);
 
 exit:
-    spin_unlock_irqrestore(&ptpdev->lock, flags);
+    mutex_unlock(&ptpdev->lock);
 
     return 0;
 }
 
 static int lan865x_ptp_adjtime(struct ptp_clock_info* ptp_info, s64 delta_ns) {
-    unsigned long flags;
-
     struct lan865x_priv* priv = get_lan865x_priv_by_ptp_info(ptp_info);
     struct ptp_device* ptpdev = priv->ptpdev;
 
     bool is_negative = false;
     timestamp_t hw_timestamp = 0;
     timestamp_t curr_hw_timestamp = 0 ;
+    unsigned long flags;
+    int ret;
 
     LAN865X_DEBUG("lan865x: call %s\n", __func__);
 
-    spin_lock_irqsave(&ptpdev->lock, flags);
-
     if (delta_ns == 0) {
         return 0;
     }
 
+    mutex_lock(&ptpdev->lock);
+
+    /* Servo steps below one second are applied by the MAC in a single
+     * write of MAC_TA, so the SPI latency doesn't add to the step.
+     */
+    if (abs(delta_ns) < NS_IN_1S) {
+        if (delta_ns < 0)
+            ret = lan865x_sub_sys_clock(priv, (u32)-delta_ns);
+        else
+            ret = lan865x_add_sys_clock(priv, (u32)delta_ns);
+
+        if (!ret) {
+            /* Step the software clock the same way, the rate measurement
+             * over the last sample stays valid.
+             */
+            spin_lock_irqsave(&ptpdev->tc_lock, flags);
+            timecounter_adjtime(&ptpdev->tc, delta_ns);
+            ptpdev->tc_last_hw_ns += delta_ns;
+            spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+        }
+
+        LAN865X_DEBUG("%s: delta_ns = %lld via MAC_TA\n", __func__, delta_ns);
+
+        mutex_unlock(&ptpdev->lock);
+
+        return ret;
+    }
+
     hw_timestamp = lan865x_get_sys_clock(priv);
 
     if (delta_ns < 0) {
@@ -148,15 +413,17 @@ static int lan865x_ptp_adjtime(struct ptp_clock_info* ptp_info, s64 delta_ns) {
 
     hw_timestamp += is_negative ? -delta_ns : delta_ns;
 
-    lan865x_set_sys_clock(priv, hw_timestamp);
+    ret = lan865x_set_sys_clock(priv, hw_timestamp);
     curr_hw_timestamp = lan865x_get_sys_clock(priv);
 
     LAN865X_DEBUG("%s: delta_ns = %c%llu, curr_hw_timestamp = %llu\n", __func__, is_negative ? '-' : '+', delta_ns,
                   curr_hw_timestamp);
 
-    spin_unlock_irqrestore(&ptpdev->lock, flags);
+    lan865x_ptp_tc_reset(ptpdev);
 
-    return 0;
+    mutex_unlock(&ptpdev->lock);
+
+    return ret;
 }
 
 static int lan865x_ptp_gettimex64(struct ptp_clock_info* ptp_info, struct timespec64* res_ts,
@@ -169,39 +436,45 @@ static int lan865x_ptp_gettimex64(struct ptp_clock_info* ptp_info, struct timesp
     struct lan865x_priv* priv = get_lan865x_priv_by_ptp_info(ptp_info);
     struct ptp_device* ptpdev = priv->ptpdev;
 
-    spin_lock_irqsave(&ptpdev->lock, flags);
-
-    ptp_read_system_prets(sts);
-    timestamp = lan865x_get_sys_clock(priv);
-    ptp_read_system_postts(sts);
+    /* The timecounter is derived from the system clock, so system timestamps
+     * taken around it would only measure the resampling. Callers asking for
+     * them, e.g. phc2sys, get a real hardware read.
+     */
+    if (hw_gettime || sts) {
+        mutex_lock(&ptpdev->lock);
+        timestamp = lan865x_get_sys_clock_sts(priv, sts);
+        mutex_unlock(&ptpdev->lock);
+    } else {
+        spin_lock_irqsave(&ptpdev->tc_lock, flags);
+        timestamp = timecounter_read(&ptpdev->tc);
+        spin_unlock_irqrestore(&ptpdev->tc_lock, flags);
+    }
 
     res_ts->tv_sec = timestamp / NS_IN_1S;
     res_ts->tv_nsec = timestamp % NS_IN_1S;
 
-    spin_unlock_irqrestore(&ptpdev->lock, flags);
-
     return 0;
 }
 
 static int lan865x_ptp_settime64(struct ptp_clock_info* ptp_info, const struct timespec64* set_ts) {
     (void)set_ts;
     u64 host_timestamp;
-    unsigned long flags;
 
     struct lan865x_priv* priv = get_lan865x_priv_by_ptp_info(ptp_info);
     struct ptp_device* ptpdev = priv->ptpdev;
 
     LAN865X_DEBUG("lan865x: call %s", __func__);
 
-    spin_lock_irqsave(&ptpdev->lock, flags);
+    mutex_lock(&ptpdev->lock);
 
     /* Get host timestamp */
     host_timestamp = (u64)set_ts->tv_sec * NS_IN_1S + set_ts->tv_nsec;
 
     // TODO add/sub
     lan865x_set_sys_clock(priv, host_timestamp);
+    lan865x_ptp_tc_reset(ptpdev);
 
-    spin_unlock_irqrestore(&ptpdev->lock, flags);
+    mutex_unlock(&ptpdev->lock);
 
     return 0;
 }
@@ -226,12 +499,24 @@ struct ptp_device* ptp_device_init(struct device* dev, struct oa_tc6* tc6, s32 m
         .adjtime = lan865x_ptp_adjtime,
         .gettimex64 = lan865x_ptp_gettimex64,
         .settime64 = lan865x_ptp_settime64,
+        .do_aux_work = lan865x_ptp_do_aux_work,
     };
 
-    spin_lock_init(&ptpdev->lock);
+    mutex_init(&ptpdev->lock);
+    spin_lock_init(&ptpdev->tc_lock);
 
     ptpdev->dev = dev;
     ptpdev->tc6 = tc6;
+    ptpdev->ptp_info = ptp_info;
+    // TODO: read from register
+    ptpdev->ti_subnano_b24 = TICKS_SCALE << TISUBNS_FRAC_BITS;
+
+    ptpdev->cc.read = lan865x_ptp_tc_read;
+    ptpdev->cc.mask = CYCLECOUNTER_MASK(64);
+    ptpdev->cc.shift = PTP_TC_SHIFT;
+    ptpdev->cc.mult = lan865x_ptp_tc_nominal_mult(ptpdev->ti_subnano_b24);
+    timecounter_init(&ptpdev->tc, &ptpdev->cc, 0);
+    lan865x_ptp_tc_resample(ptpdev);
 
     ptpdev->ptp_clock = ptp_clock_register(&ptpdev->ptp_info, dev);
     if (IS_ERR(ptpdev->ptp_clock)) {
@@ -240,28 +525,21 @@ struct ptp_device* ptp_device_init(struct device* dev, struct oa_tc6* tc6, s32 m
         return NULL;
     }
 
-    ptpdev->ptp_info = ptp_info;
-    // TODO: read from register
-    ptpdev->ti_subnano_b24 = TICKS_SCALE << TISUBNS_FRAC_BITS;
-
-    ptpdev->ptp_thread = kthread_run(lan865x_ptp_thread_handler, ptpdev, "lan865x-ptp-thread");
-    if (IS_ERR(ptpdev->ptp_thread)) {
-        dev_err(ptpdev->dev, "Failed to create PTP thread\n");
+    /* Unmask the Tx Timestamp Capture interrupts in OA_MASK0 */
+    if (oa_tc6_register_ts_capture_handler(tc6, lan865x_ptp_ts_capture, ptpdev)) {
+        dev_err(dev, "Failed to enable Tx timestamp capture interrupts\n");
+        ptp_clock_unregister(ptpdev->ptp_clock);
         kfree(ptpdev);
         return NULL;
     }
 
-    /* TODO: Configure the OA_MASK0 register to generate an interrupt on Tx Timestamp Capture.
-    u32 regval;
-    regval = 0;
-    oa_tc6_read_register(ptpdev->tc6, 0x0000000C, &regval); // 0x0000_000C = MMS0_OA_MASK0
-    LAN865X_DEBUG("%s: OA_MASK0 = 0x%08X\n", __func__, regval);
-    regval &= ~(TS_A_INT_ENABLE | TS_B_INT_ENABLE | TS_C_INT_ENABLE);
-    oa_tc6_write_register(ptpdev->tc6, 0x0000000C, &regval); // 0x0000_000C = MMS0_OA_MASK0
-    regval = 0;
-    oa_tc6_read_register(ptpdev->tc6, 0x0000000C, &regval); // 0x0000_000C = MMS0_OA_MASK0
-    LAN865X_DEBUG("%s: OA_MASK0 = 0x%08X\n", __func__, regval);
-    */
+    ptp_schedule_worker(ptpdev->ptp_clock, PTP_TC_RESAMPLE_INTERVAL);
 
     return ptpdev;
 }
+
+void ptp_device_destroy(struct ptp_device* ptpdev) {
+    oa_tc6_register_ts_capture_handler(ptpdev->tc6, NULL, NULL);
+    ptp_clock_unregister(ptpdev->ptp_clock);
+    kfree(ptpdev);
+}
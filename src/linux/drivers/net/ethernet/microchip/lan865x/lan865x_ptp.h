@@ -4,7 +4,10 @@
 #include "lan865x_arch.h"
 
 bool is_gptp_packet(const struct sk_buff* skb);
+u8 lan865x_ptp_txts_request(struct lan865x_priv* priv, struct sk_buff* skb);
+void lan865x_ptp_txts_cancel(struct lan865x_priv* priv, u8 tx_id);
+void lan865x_ptp_txts_purge(struct lan865x_priv* priv);
 struct ptp_device* ptp_device_init(struct device* dev, struct oa_tc6* tc6, s32 max_adj);
-void ptp_device_destroy(struct ptp_device* ptp);
+void ptp_device_destroy(struct ptp_device* ptpdev);
 
 #endif /* LAN865X_GPTP_H */
@@ -13,13 +13,20 @@
 /* NOLINTBEGIN */
 
 #include <linux/bitfield.h>
+#include <linux/debugfs.h>
 #include <linux/iopoll.h>
+#include <linux/log2.h>
 #include <linux/mdio.h>
 #include <linux/oa_tc6.h>
 #include <linux/phy.h>
+#include <linux/property.h>
 #include <linux/ptp_classify.h>
+#include <linux/regmap.h>
+#include <linux/version.h>
+#include <net/page_pool/helpers.h>
 
 #ifdef FRAME_TIMESTAMP_ENABLE
+#include <asm/unaligned.h>
 #include <linux/if_vlan.h>
 #endif /* FRAME_TIMESTAMP_ENABLE */
 
@@ -36,15 +43,31 @@
 #define OA_TC6_REG_CONFIG0 0x0004
 #define CONFIG0_SYNC BIT(15)
 #define CONFIG0_ZARFE_ENABLE BIT(12)
+#define CONFIG0_TXCTE BIT(9) /* Transmit Cut-Through Enable */
+#define CONFIG0_RXCTE BIT(8) /* Receive Cut-Through Enable */
+#define CONFIG0_FTSE BIT(7)  /* Frame Timestamp Enable */
+#define CONFIG0_CPS GENMASK(2, 0) /* Chunk Payload Size, log2 of the size in bytes */
 
 /* Status Register #0 */
 #define OA_TC6_REG_STATUS0 0x0008
+#define STATUS0_TTSCAC BIT(10) /* Transmit Timestamp Capture Available C */
+#define STATUS0_TTSCAB BIT(9)  /* Transmit Timestamp Capture Available B */
+#define STATUS0_TTSCAA BIT(8)  /* Transmit Timestamp Capture Available A */
+#define STATUS0_TTSCA (STATUS0_TTSCAA | STATUS0_TTSCAB | STATUS0_TTSCAC)
 #define STATUS0_RESETC BIT(6) /* Reset Complete */
 #define STATUS0_HEADER_ERROR BIT(5)
 #define STATUS0_LOSS_OF_FRAME_ERROR BIT(4)
 #define STATUS0_RX_BUFFER_OVERFLOW_ERROR BIT(3)
+#define STATUS0_TX_BUFFER_UNDERFLOW_ERROR BIT(2)
 #define STATUS0_TX_PROTOCOL_ERROR BIT(0)
 
+/* Status Register #1 */
+#define OA_TC6_REG_STATUS1 0x0009
+#define STATUS1_TTSCMC BIT(26) /* Transmit Timestamp Capture Missed C */
+#define STATUS1_TTSCMB BIT(25) /* Transmit Timestamp Capture Missed B */
+#define STATUS1_TTSCMA BIT(24) /* Transmit Timestamp Capture Missed A */
+#define STATUS1_TTSCM (STATUS1_TTSCMA | STATUS1_TTSCMB | STATUS1_TTSCMC)
+
 /* Buffer Status Register */
 #define OA_TC6_REG_BUFFER_STATUS 0x000B
 #define BUFFER_STATUS_TX_CREDITS_AVAILABLE GENMASK(15, 8)
@@ -52,11 +75,17 @@
 
 /* Interrupt Mask Register #0 */
 #define OA_TC6_REG_INT_MASK0 0x000C
+#define INT_MASK0_TTSCA_MASK (BIT(8) | BIT(9) | BIT(10))
 #define INT_MASK0_HEADER_ERR_MASK BIT(5)
 #define INT_MASK0_LOSS_OF_FRAME_ERR_MASK BIT(4)
 #define INT_MASK0_RX_BUFFER_OVERFLOW_ERR_MASK BIT(3)
+#define INT_MASK0_TX_BUFFER_UNDERFLOW_ERR_MASK BIT(2)
 #define INT_MASK0_TX_PROTOCOL_ERR_MASK BIT(0)
 
+/* Interrupt Mask Register #1 */
+#define OA_TC6_REG_INT_MASK1 0x000D
+#define INT_MASK1_TTSCM_MASK (BIT(24) | BIT(25) | BIT(26))
+
 /* PHY Clause 22 registers base address and mask */
 #define OA_TC6_PHY_STD_REG_ADDR_BASE 0xFF00
 #define OA_TC6_PHY_STD_REG_ADDR_MASK 0x1F
@@ -87,8 +116,10 @@
 #define OA_TC6_DATA_FOOTER_DATA_VALID BIT(21)
 #define OA_TC6_DATA_FOOTER_START_VALID BIT(20)
 #define OA_TC6_DATA_FOOTER_START_WORD_OFFSET GENMASK(19, 16)
+#define OA_TC6_DATA_FOOTER_FRAME_DROP BIT(15)
 #define OA_TC6_DATA_FOOTER_END_VALID BIT(14)
 #define OA_TC6_DATA_FOOTER_END_BYTE_OFFSET GENMASK(13, 8)
+#define OA_TC6_DATA_FOOTER_RX_TS_ADDED BIT(7)
 #define OA_TC6_DATA_FOOTER_TX_CREDITS GENMASK(5, 1)
 
 /* PHY – Clause 45 registers memory map selector (MMS) as per table 6 in the
@@ -104,16 +135,105 @@
 #define OA_TC6_CTRL_REG_VALUE_SIZE 4
 #define OA_TC6_CTRL_IGNORED_SIZE 4
 #define OA_TC6_CTRL_MAX_REGISTERS 128
+#define OA_TC6_REGMAP_MAX_REGISTER 0x000FFFFF /* MMS (4 bits) and address (16 bits) */
+#define OA_TC6_CTRL_BATCH_BUF_SIZE 1024
+#define OA_TC6_CTRL_BATCH_MAX_XFERS 32
 #define OA_TC6_CTRL_SPI_BUF_SIZE \
     (OA_TC6_CTRL_HEADER_SIZE + (OA_TC6_CTRL_MAX_REGISTERS * OA_TC6_CTRL_REG_VALUE_SIZE) + OA_TC6_CTRL_IGNORED_SIZE)
-#define OA_TC6_CHUNK_PAYLOAD_SIZE 64
+#define OA_TC6_CHUNK_PAYLOAD_SIZE_MIN 8
+#define OA_TC6_CHUNK_PAYLOAD_SIZE_MAX 64
 #define OA_TC6_DATA_HEADER_SIZE 4
-#define OA_TC6_CHUNK_SIZE (OA_TC6_DATA_HEADER_SIZE + OA_TC6_CHUNK_PAYLOAD_SIZE)
+#define OA_TC6_DATA_FOOTER_SIZE 4
 #define OA_TC6_MAX_TX_CHUNKS 48
-#define OA_TC6_SPI_DATA_BUF_SIZE (OA_TC6_MAX_TX_CHUNKS * OA_TC6_CHUNK_SIZE)
+#define OA_TC6_SPI_DATA_BUF_SIZE(tc6) (OA_TC6_MAX_TX_CHUNKS * (tc6)->chunk_size)
+#define OA_TC6_TX_RING_MAX_SIZE 256 /* Must be a power of 2 */
+#define OA_TC6_TX_RING_MIN_SIZE 2
+#define OA_TC6_TX_RING_DEFAULT_SIZE 32
+#define OA_TC6_RX_SKB_Q_MAX_LEN 512
+#define OA_TC6_RX_PAGE_POOL_SIZE 64
+#define OA_TC6_RX_PAGE_BIAS USHRT_MAX /* Fragment references taken on each rx pool page */
+#define OA_TC6_RX_HDR_SIZE 128        /* Max. headers pulled into the skb linear part */
+#ifdef FRAME_TIMESTAMP_ENABLE
+#define OA_TC6_RX_TIMESTAMP_SIZE 8 /* Timestamp the MAC-PHY prepends to rx frames, at most */
+#define OA_TC6_RX_TIMESTAMP32_SIZE 4
+#define OA_TC6_RX_TIMESTAMP32_SECONDS GENMASK(31, 30)
+#define OA_TC6_RX_TIMESTAMP32_NANOSECONDS GENMASK(29, 0)
+#else /* FRAME_TIMESTAMP_ENABLE */
+#define OA_TC6_RX_TIMESTAMP_SIZE 0
+#endif /* FRAME_TIMESTAMP_ENABLE */
+#define OA_TC6_MAX_SPI_TX_SEGS (4 * OA_TC6_MAX_TX_CHUNKS)
+#define OA_TC6_MAX_SPI_RX_SEGS (2 * OA_TC6_MAX_TX_CHUNKS)
+#define OA_TC6_TX_SG_MIN_LEN 16 /* Shorter tx skb pieces are copied instead */
+
+static bool tx_chunk_packing = true;
+module_param(tx_chunk_packing, bool, 0644);
+MODULE_PARM_DESC(tx_chunk_packing,
+                 "Start the next tx frame in the same chunk as the end of the previous one (0 = one frame per chunk)");
+
+static int rx_napi_weight = NAPI_POLL_WEIGHT;
+module_param(rx_napi_weight, int, 0444);
+MODULE_PARM_DESC(rx_napi_weight, "Maximum number of rx frames delivered per NAPI poll (1-64)");
+
+static bool rx_page_pool;
+module_param(rx_page_pool, bool, 0444);
+MODULE_PARM_DESC(rx_page_pool, "Receive chunk payloads into page_pool pages and attach them to skbs without copying");
+
+static bool tx_sg;
+module_param(tx_sg, bool, 0444);
+MODULE_PARM_DESC(tx_sg, "Send tx frames straight from the (possibly fragmented) skbs instead of copying them");
+
+static int chunk_payload_size = OA_TC6_CHUNK_PAYLOAD_SIZE_MAX;
+module_param(chunk_payload_size, int, 0444);
+MODULE_PARM_DESC(chunk_payload_size,
+                 "Data chunk payload size in bytes, 8, 16, 32 or 64 (overridden by the chunk-payload-size device property)");
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+static bool rx_timestamp_32bit;
+module_param(rx_timestamp_32bit, bool, 0444);
+MODULE_PARM_DESC(rx_timestamp_32bit,
+                 "Prepend 32-bit instead of 64-bit timestamps to rx frames, the seconds are extended from the PHC");
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
+static bool spi_pipeline;
+module_param(spi_pipeline, bool, 0444);
+MODULE_PARM_DESC(spi_pipeline,
+                 "Prepare and parse SPI data transfers while the previous one is on the wire (not with tx_sg/rx_page_pool)");
+
 #define STATUS0_RESETC_POLL_DELAY 1000
 #define STATUS0_RESETC_POLL_TIMEOUT 1000000
 
+/* Tx ring entry, filled by oa_tc6_start_xmit() and drained by the SPI kthread */
+struct oa_tc6_tx_desc {
+    struct sk_buff* skb;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    u8 ts_capture_mode;
+#endif /* FRAME_TIMESTAMP_ENABLE */
+};
+
+/* Part of a SPI data transfer buffer, either on the tx or on the rx side */
+struct oa_tc6_spi_seg {
+    u8* buf;
+    u16 len;
+};
+
+/* Single transfer SPI message set up once and reused for every transaction */
+struct oa_tc6_spi_msg {
+    struct spi_message msg;
+    struct spi_transfer xfer;
+    bool optimized;
+};
+
+/* One of the two SPI data transfer buffers used by the spi_pipeline mode */
+struct oa_tc6_spi_data_buf {
+    void* tx_buf;
+    void* rx_buf;
+    struct spi_transfer xfer;
+    struct spi_message msg;
+    struct completion done;
+    u16 len;
+    u16 tx_chunks;
+};
+
 /* Internal structure for MAC-PHY drivers */
 struct oa_tc6 {
     struct device* dev;
@@ -122,14 +242,52 @@ struct oa_tc6 {
     struct mii_bus* mdiobus;
     struct spi_device* spi;
     struct mutex spi_ctrl_lock; /* Protects spi control transfer */
-    spinlock_t tx_skb_lock;     /* Protects tx skb handling */
     void* spi_ctrl_tx_buf;
     void* spi_ctrl_rx_buf;
     void* spi_data_tx_buf;
     void* spi_data_rx_buf;
+    u8 chunk_payload_size; /* Data chunk payload size, 8 to 64 bytes */
+    u16 chunk_size;        /* Data chunk size with the header or footer */
     struct sk_buff* ongoing_tx_skb;
-    struct sk_buff* waiting_tx_skb;
+    struct oa_tc6_tx_desc* tx_ring;
+    u32 tx_ring_head; /* Producer index, only written by oa_tc6_start_xmit() */
+    u32 tx_ring_tail; /* Consumer index, only written by the SPI kthread */
+    u32 tx_ring_size; /* Usable ring depth, configured via ethtool ringparam */
     struct sk_buff* rx_skb;
+    struct sk_buff_head rx_skb_q; /* Completed rx frames waiting for NAPI */
+    struct napi_struct napi;
+    struct page_pool* rx_page_pool; /* Only set if the rx_page_pool mode is used */
+    struct page* rx_page;           /* Pool page the rx chunk payloads are received into */
+    u8* rx_chunk_base;              /* Payload of the first rx chunk of the last transfer */
+    u32 rx_page_offset;             /* Next free chunk payload slot in rx_page */
+    long rx_page_frags;             /* Fragment references of rx_page handed out to skbs */
+    __be32* spi_data_rx_footers;
+    struct spi_transfer* spi_data_xfers;
+    struct oa_tc6_spi_seg* spi_tx_segs;
+    struct oa_tc6_spi_seg* spi_rx_segs;
+    u16 no_of_spi_tx_segs;
+    u16 spi_tx_seg_cursor;        /* Offset in spi_data_tx_buf covered by the tx segments */
+    struct sk_buff_head tx_done_q; /* Sent tx skbs still mapped by the tx segments */
+    bool tx_sg;
+    struct oa_tc6_spi_data_buf spi_data_bufs[2];
+    bool spi_pipeline;
+    struct regmap* regmap;
+    struct task_struct* ctrl_batch_owner; /* Writing a register sequence, holds spi_ctrl_lock */
+    void* ctrl_batch_tx_buf;
+    void* ctrl_batch_rx_buf;
+    struct spi_transfer* ctrl_batch_xfers;
+    u16 ctrl_batch_len;
+    u8 no_of_ctrl_batch_xfers;
+    u32 ctrl_seq_values[OA_TC6_CTRL_MAX_REGISTERS];
+    struct dentry* debugfs_dir;
+    atomic_long_t regcache_reads;  /* Reads of cached registers */
+    atomic_long_t regcache_misses; /* Reads of cached registers which went to the MAC-PHY */
+    atomic_long_t volatile_reads;
+    struct oa_tc6_spi_msg spi_ctrl_msg;   /* Single register control transaction */
+    struct oa_tc6_spi_msg* spi_data_msgs; /* Data transfers, indexed by no. of chunks - 1 */
+    spinlock_t ts_capture_lock; /* Held while the handler runs, so it can be unregistered safely */
+    oa_tc6_ts_capture_handler_t ts_capture_handler; /* Called for the TTSCAx/TTSCMx status bits */
+    void* ts_capture_ctx;
     struct task_struct* spi_thread;
     wait_queue_head_t spi_wq;
     u16 tx_skb_offset;
@@ -137,11 +295,15 @@ struct oa_tc6 {
     u16 tx_credits;
     u8 rx_chunks_available;
     bool rx_buf_overflow;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    bool rx_ts_added;   /* The MAC-PHY prepended a timestamp to the ongoing rx frame */
+    u32 rx_ts_ref_sec; /* Recent PHC seconds, extends 32-bit rx timestamps */
+    int rx_ts_filter;  /* HWTSTAMP_FILTER_* for the frames passed up with their timestamp */
+#endif /* FRAME_TIMESTAMP_ENABLE */
     bool int_flag;
 
 #ifdef FRAME_TIMESTAMP_ENABLE
     u8 ongoing_tx_ts_capture_mode;
-    u8 waiting_tx_ts_capture_mode;
 #endif /* FRAME_TIMESTAMP_ENABLE */
 };
 
@@ -174,48 +336,9 @@ enum oa_tc6_data_end_valid_info {
 
 #define NS_IN_1S (1000000000)
 
-// TODO: Cleanup
-enum tsn_timestamp_id {
-    TSN_TIMESTAMP_ID_NONE = 0,
-    TSN_TIMESTAMP_ID_GPTP = 1,
-    TSN_TIMESTAMP_ID_NORMAL = 2,
-    TSN_TIMESTAMP_ID_RESERVED1 = 3,
-
-    TSN_TIMESTAMP_ID_MAX,
-};
-
-// TODO: Cleanup
-struct lan865x_priv {
-    struct work_struct multicast_work;
-    struct net_device* netdev;
-    struct spi_device* spi;
-    struct oa_tc6* tc6;
-
-    struct ptp_device* ptpdev;
-    struct hwtstamp_config tstamp_config;
-	struct sk_buff *waiting_txts_skb[TSN_TIMESTAMP_ID_MAX-1];
-
-    uint64_t total_tx_count;
-    uint64_t total_tx_drop_count;
-};
-
-// TODO: Cleanup
-struct timestamp_format {
-    uint32_t seconds;
-    union {
-        uint32_t _nano;
-        struct {
-            uint32_t nanoseconds : 30;
-            uint32_t _rsvd : 2;
-        };
-    };
-};
-
 // TODO: Cleanup
 static bool filter_rx_timestamp(struct oa_tc6* tc6, uint8_t* data) {
-    struct net_device* netdev = tc6->netdev;
-    struct lan865x_priv* priv = netdev_priv(netdev);
-    int rx_filter = priv->tstamp_config.rx_filter;
+    int rx_filter = READ_ONCE(tc6->rx_ts_filter);
     struct ethhdr* eth;
     uint8_t* payload = data;
     u16 eth_type;
@@ -260,10 +383,27 @@ static bool filter_rx_timestamp(struct oa_tc6* tc6, uint8_t* data) {
 }
 #endif /* FRAME_TIMESTAMP_ENABLE */
 
+static struct oa_tc6_spi_msg* oa_tc6_get_spi_msg(struct oa_tc6* tc6, enum oa_tc6_header_type header_type,
+                                                 u16 length) {
+    if (header_type == OA_TC6_CTRL_HEADER)
+        return length == tc6->spi_ctrl_msg.xfer.len ? &tc6->spi_ctrl_msg : NULL;
+
+    if (!tc6->spi_data_msgs || !length || length % tc6->chunk_size ||
+        length > OA_TC6_MAX_TX_CHUNKS * tc6->chunk_size)
+        return NULL;
+
+    return &tc6->spi_data_msgs[length / tc6->chunk_size - 1];
+}
+
 static int oa_tc6_spi_transfer(struct oa_tc6* tc6, enum oa_tc6_header_type header_type, u16 length) {
+    struct oa_tc6_spi_msg* spi_msg = oa_tc6_get_spi_msg(tc6, header_type, length);
     struct spi_transfer xfer = {0};
     struct spi_message msg;
 
+    /* Use the prepared message if there is one for this transaction */
+    if (spi_msg)
+        return spi_sync(tc6->spi, &spi_msg->msg);
+
     if (header_type == OA_TC6_DATA_HEADER) {
         xfer.tx_buf = tc6->spi_data_tx_buf;
         xfer.rx_buf = tc6->spi_data_rx_buf;
@@ -279,6 +419,199 @@ static int oa_tc6_spi_transfer(struct oa_tc6* tc6, enum oa_tc6_header_type heade
     return spi_sync(tc6->spi, &msg);
 }
 
+static void oa_tc6_init_spi_msg(struct oa_tc6* tc6, struct oa_tc6_spi_msg* spi_msg, void* tx_buf, void* rx_buf,
+                                u16 length) {
+    spi_msg->xfer.tx_buf = tx_buf;
+    spi_msg->xfer.rx_buf = rx_buf;
+    spi_msg->xfer.len = length;
+    spi_message_init(&spi_msg->msg);
+    spi_message_add_tail(&spi_msg->xfer, &spi_msg->msg);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+    /* Let the SPI core and controller validate and prepare the message
+     * once. It still works unoptimized if that fails.
+     */
+    spi_msg->optimized = !spi_optimize_message(tc6->spi, &spi_msg->msg);
+#endif
+}
+
+static void oa_tc6_release_spi_msg(struct oa_tc6_spi_msg* spi_msg) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 10, 0)
+    if (spi_msg->optimized)
+        spi_unoptimize_message(&spi_msg->msg);
+#endif
+    spi_msg->optimized = false;
+}
+
+static int oa_tc6_spi_msgs_init(struct oa_tc6* tc6) {
+    tc6->spi_data_msgs = devm_kcalloc(&tc6->spi->dev, OA_TC6_MAX_TX_CHUNKS, sizeof(*tc6->spi_data_msgs), GFP_KERNEL);
+    if (!tc6->spi_data_msgs)
+        return -ENOMEM;
+
+    /* Register accesses are mostly single register reads and writes, and
+     * the data transfer is always a whole number of chunks.
+     */
+    oa_tc6_init_spi_msg(tc6, &tc6->spi_ctrl_msg, tc6->spi_ctrl_tx_buf, tc6->spi_ctrl_rx_buf,
+                        OA_TC6_CTRL_HEADER_SIZE + OA_TC6_CTRL_REG_VALUE_SIZE + OA_TC6_CTRL_IGNORED_SIZE);
+
+    for (int i = 0; i < OA_TC6_MAX_TX_CHUNKS; i++)
+        oa_tc6_init_spi_msg(tc6, &tc6->spi_data_msgs[i], tc6->spi_data_tx_buf, tc6->spi_data_rx_buf,
+                            (i + 1) * tc6->chunk_size);
+
+    return 0;
+}
+
+static void oa_tc6_spi_msgs_exit(struct oa_tc6* tc6) {
+    if (!tc6->spi_data_msgs)
+        return;
+
+    oa_tc6_release_spi_msg(&tc6->spi_ctrl_msg);
+    for (int i = 0; i < OA_TC6_MAX_TX_CHUNKS; i++)
+        oa_tc6_release_spi_msg(&tc6->spi_data_msgs[i]);
+}
+
+static void oa_tc6_rx_page_release(struct oa_tc6* tc6) {
+    if (!tc6->rx_page)
+        return;
+
+    /* Drop the references which were not handed out to skbs. The page goes
+     * back to the pool once the skbs holding the others are freed.
+     */
+    if (!page_pool_defrag_page(tc6->rx_page, OA_TC6_RX_PAGE_BIAS - tc6->rx_page_frags))
+        page_pool_put_defragged_page(tc6->rx_page_pool, tc6->rx_page, -1, false);
+
+    tc6->rx_page = NULL;
+}
+
+static int oa_tc6_rx_page_reserve(struct oa_tc6* tc6, u16 no_of_chunks) {
+    struct page* page;
+
+    if (tc6->rx_page && tc6->rx_page_offset + no_of_chunks * tc6->chunk_payload_size <= PAGE_SIZE)
+        return 0;
+
+    oa_tc6_rx_page_release(tc6);
+
+    page = page_pool_alloc_pages(tc6->rx_page_pool, GFP_KERNEL);
+    if (!page)
+        return -ENOMEM;
+
+    page_pool_fragment_page(page, OA_TC6_RX_PAGE_BIAS);
+    tc6->rx_page = page;
+    tc6->rx_page_offset = 0;
+    tc6->rx_page_frags = 0;
+
+    return 0;
+}
+
+static void oa_tc6_spi_add_seg(struct oa_tc6_spi_seg* segs, u16* no_of_segs, u8* buf, u16 len) {
+    struct oa_tc6_spi_seg* last;
+
+    if (!len)
+        return;
+
+    /* Extend the previous segment if the new one directly follows it */
+    if (*no_of_segs) {
+        last = &segs[*no_of_segs - 1];
+        if (last->buf + last->len == buf) {
+            last->len += len;
+            return;
+        }
+    }
+
+    segs[*no_of_segs].buf = buf;
+    segs[*no_of_segs].len = len;
+    (*no_of_segs)++;
+}
+
+static int oa_tc6_prepare_rx_page_segs(struct oa_tc6* tc6, u16 length, u16* no_of_segs) {
+    u16 no_of_chunks = length / tc6->chunk_size;
+    int ret;
+
+    ret = oa_tc6_rx_page_reserve(tc6, no_of_chunks);
+    if (ret)
+        return ret;
+
+    tc6->rx_chunk_base = page_address(tc6->rx_page) + tc6->rx_page_offset;
+
+    /* The rx chunk payload is clocked in while the tx chunk header and the
+     * first part of its payload go out, and the rx footer while the rest of
+     * the tx payload goes out. Split each chunk accordingly so that the rx
+     * payloads land back to back in the pool page with the footers skipped.
+     */
+    for (int i = 0; i < no_of_chunks; i++) {
+        oa_tc6_spi_add_seg(tc6->spi_rx_segs, no_of_segs, tc6->rx_chunk_base + i * tc6->chunk_payload_size,
+                           tc6->chunk_payload_size);
+        oa_tc6_spi_add_seg(tc6->spi_rx_segs, no_of_segs, (u8*)&tc6->spi_data_rx_footers[i],
+                           OA_TC6_DATA_FOOTER_SIZE);
+    }
+
+    return 0;
+}
+
+static int oa_tc6_spi_data_transfer(struct oa_tc6* tc6, u16 length) {
+    struct oa_tc6_spi_seg* tx_seg = tc6->spi_tx_segs;
+    struct oa_tc6_spi_seg* rx_seg = tc6->spi_rx_segs;
+    struct spi_transfer* xfer = tc6->spi_data_xfers;
+    u16 tx_seg_offset = 0, rx_seg_offset = 0;
+    u16 no_of_rx_segs = 0;
+    struct spi_message msg;
+    u16 done = 0;
+    int ret;
+
+    if (!tc6->tx_sg && !tc6->rx_page_pool)
+        return oa_tc6_spi_transfer(tc6, OA_TC6_DATA_HEADER, length);
+
+    /* Whatever is not mapped to tx skb data is sent from the tx buffer */
+    oa_tc6_spi_add_seg(tc6->spi_tx_segs, &tc6->no_of_spi_tx_segs, tc6->spi_data_tx_buf + tc6->spi_tx_seg_cursor,
+                       length - tc6->spi_tx_seg_cursor);
+
+    if (tc6->rx_page_pool) {
+        ret = oa_tc6_prepare_rx_page_segs(tc6, length, &no_of_rx_segs);
+        if (ret)
+            return ret;
+    } else {
+        oa_tc6_spi_add_seg(tc6->spi_rx_segs, &no_of_rx_segs, tc6->spi_data_rx_buf, length);
+    }
+
+    /* Build one spi_transfer for each span where neither the tx nor the rx
+     * segment changes. Chip select stays asserted for the whole message.
+     */
+    spi_message_init(&msg);
+
+    while (done < length) {
+        u16 len = min(tx_seg->len - tx_seg_offset, rx_seg->len - rx_seg_offset);
+
+        memset(xfer, 0, sizeof(*xfer));
+        xfer->tx_buf = tx_seg->buf + tx_seg_offset;
+        xfer->rx_buf = rx_seg->buf + rx_seg_offset;
+        xfer->len = len;
+        spi_message_add_tail(xfer++, &msg);
+
+        done += len;
+        tx_seg_offset += len;
+        rx_seg_offset += len;
+
+        if (tx_seg_offset == tx_seg->len) {
+            tx_seg++;
+            tx_seg_offset = 0;
+        }
+        if (rx_seg_offset == rx_seg->len) {
+            rx_seg++;
+            rx_seg_offset = 0;
+        }
+    }
+
+    ret = spi_sync(tc6->spi, &msg);
+    if (ret)
+        return ret;
+
+    /* Received payloads may be referenced by rx skbs from now on */
+    if (tc6->rx_page_pool)
+        tc6->rx_page_offset += length / tc6->chunk_size * tc6->chunk_payload_size;
+
+    return 0;
+}
+
 static int oa_tc6_get_parity(u32 p) {
     /* Public domain code snippet, lifted from
      * http://www-graphics.stanford.edu/~seander/bithacks.html
@@ -327,10 +660,7 @@ static void oa_tc6_prepare_ctrl_spi_buf(struct oa_tc6* tc6, u32 address, u32 val
         oa_tc6_update_ctrl_write_data(tc6, value, length);
 }
 
-static int oa_tc6_check_ctrl_write_reply(struct oa_tc6* tc6, u8 size) {
-    u8* tx_buf = tc6->spi_ctrl_tx_buf;
-    u8* rx_buf = tc6->spi_ctrl_rx_buf;
-
+static int oa_tc6_check_ctrl_write_reply(u8* tx_buf, u8* rx_buf, u16 size) {
     rx_buf += OA_TC6_CTRL_IGNORED_SIZE;
 
     /* The echoed control write must match with the one that was
@@ -381,7 +711,7 @@ static int oa_tc6_perform_ctrl(struct oa_tc6* tc6, u32 address, u32 value[], u8
 
     /* Check echoed/received control write command reply for errors */
     if (reg_op == OA_TC6_CTRL_REG_WRITE)
-        return oa_tc6_check_ctrl_write_reply(tc6, size);
+        return oa_tc6_check_ctrl_write_reply(tc6->spi_ctrl_tx_buf, tc6->spi_ctrl_rx_buf, size);
 
     /* Check echoed/received control read command reply for errors */
     ret = oa_tc6_check_ctrl_read_reply(tc6, size);
@@ -393,6 +723,195 @@ static int oa_tc6_perform_ctrl(struct oa_tc6* tc6, u32 address, u32 value[], u8
     return 0;
 }
 
+static int oa_tc6_flush_ctrl_batch(struct oa_tc6* tc6) {
+    u8 no_of_xfers = tc6->no_of_ctrl_batch_xfers;
+    struct spi_transfer* xfer = tc6->ctrl_batch_xfers;
+    struct spi_message msg;
+    int ret;
+
+    if (!no_of_xfers)
+        return 0;
+
+    tc6->no_of_ctrl_batch_xfers = 0;
+    tc6->ctrl_batch_len = 0;
+
+    /* Chip select is deasserted between the control commands, but not after
+     * the last one.
+     */
+    spi_message_init(&msg);
+    for (int i = 0; i < no_of_xfers; i++) {
+        xfer[i].cs_change = i < no_of_xfers - 1;
+        spi_message_add_tail(&xfer[i], &msg);
+    }
+
+    ret = spi_sync(tc6->spi, &msg);
+    if (ret) {
+        dev_err(&tc6->spi->dev, "SPI transfer failed for control: %d\n", ret);
+        return ret;
+    }
+
+    for (int i = 0; i < no_of_xfers; i++) {
+        ret = oa_tc6_check_ctrl_write_reply((u8*)xfer[i].tx_buf, xfer[i].rx_buf, xfer[i].len);
+        if (ret)
+            return ret;
+    }
+
+    return 0;
+}
+
+static int oa_tc6_queue_ctrl_write(struct oa_tc6* tc6, u32 address, u32 value[], u8 length) {
+    u16 size = oa_tc6_calculate_ctrl_buf_size(length);
+    struct spi_transfer* xfer;
+    int ret;
+
+    if (tc6->ctrl_batch_len + size > OA_TC6_CTRL_BATCH_BUF_SIZE ||
+        tc6->no_of_ctrl_batch_xfers == OA_TC6_CTRL_BATCH_MAX_XFERS) {
+        ret = oa_tc6_flush_ctrl_batch(tc6);
+        if (ret)
+            return ret;
+    }
+
+    /* A burst of all the registers doesn't fit into the batch buffer */
+    if (size > OA_TC6_CTRL_BATCH_BUF_SIZE)
+        return oa_tc6_perform_ctrl(tc6, address, value, length, OA_TC6_CTRL_REG_WRITE);
+
+    oa_tc6_prepare_ctrl_spi_buf(tc6, address, value, length, OA_TC6_CTRL_REG_WRITE);
+
+    xfer = &tc6->ctrl_batch_xfers[tc6->no_of_ctrl_batch_xfers++];
+    memset(xfer, 0, sizeof(*xfer));
+    xfer->tx_buf = tc6->ctrl_batch_tx_buf + tc6->ctrl_batch_len;
+    xfer->rx_buf = tc6->ctrl_batch_rx_buf + tc6->ctrl_batch_len;
+    xfer->len = size;
+    memcpy((void*)xfer->tx_buf, tc6->spi_ctrl_tx_buf, size);
+
+    tc6->ctrl_batch_len += size;
+
+    return 0;
+}
+
+/* Registers which are only changed by the host. They are read from the regmap
+ * cache once known, everything else is volatile and always read from the
+ * MAC-PHY.
+ */
+static const struct regmap_range oa_tc6_cached_ranges[] = {
+    regmap_reg_range(OA_TC6_REG_CONFIG0, OA_TC6_REG_CONFIG0),
+    regmap_reg_range(OA_TC6_REG_INT_MASK0, OA_TC6_REG_INT_MASK1),
+    regmap_reg_range(0x00010000, 0x00010001), /* LAN865x MAC_NCR, MAC_NCFGR */
+    regmap_reg_range(0x00010020, 0x00010023), /* LAN865x MAC_HRB, MAC_HRT, MAC_SAB1, MAC_SAT1 */
+    regmap_reg_range(0x0001006F, 0x0001006F), /* LAN865x MAC_TISUBN */
+    regmap_reg_range(0x00010077, 0x00010077), /* LAN865x MAC_TI */
+    regmap_reg_range(0x00040087, 0x00040087), /* LAN865x CDCTL0 */
+    regmap_reg_range(0x0004CA01, 0x0004CA02), /* LAN865x PLCA_CTRL0, PLCA_CTRL1 */
+};
+
+static const struct regmap_access_table oa_tc6_volatile_table = {
+    .no_ranges = oa_tc6_cached_ranges,
+    .n_no_ranges = ARRAY_SIZE(oa_tc6_cached_ranges),
+};
+
+static bool oa_tc6_reg_cached(u32 address) {
+    return regmap_reg_in_ranges(address, oa_tc6_cached_ranges, ARRAY_SIZE(oa_tc6_cached_ranges));
+}
+
+/* Register and values are passed in CPU order as the control transaction
+ * converts them anyway.
+ */
+static int oa_tc6_regmap_read(void* context, const void* reg_buf, size_t reg_size, void* val_buf, size_t val_size) {
+    struct oa_tc6* tc6 = context;
+    u32 address = *(const u32*)reg_buf;
+    u8 length = val_size / OA_TC6_CTRL_REG_VALUE_SIZE;
+    int ret;
+
+    for (int i = 0; i < length; i++) {
+        if (oa_tc6_reg_cached(address + i))
+            atomic_long_inc(&tc6->regcache_misses);
+        else
+            atomic_long_inc(&tc6->volatile_reads);
+    }
+
+    /* Commands of a register sequence must be on the bus before the read */
+    ret = oa_tc6_flush_ctrl_batch(tc6);
+    if (ret)
+        return ret;
+
+    return oa_tc6_perform_ctrl(tc6, address, val_buf, length, OA_TC6_CTRL_REG_READ);
+}
+
+static int oa_tc6_regmap_write(void* context, const void* data, size_t count) {
+    struct oa_tc6* tc6 = context;
+    u32* buf = (u32*)data;
+    u8 length = (count - sizeof(u32)) / OA_TC6_CTRL_REG_VALUE_SIZE;
+
+    if (tc6->ctrl_batch_owner == current)
+        return oa_tc6_queue_ctrl_write(tc6, buf[0], &buf[1], length);
+
+    return oa_tc6_perform_ctrl(tc6, buf[0], &buf[1], length, OA_TC6_CTRL_REG_WRITE);
+}
+
+/* The regmap lock is spi_ctrl_lock. The owner of a register sequence holds it
+ * for the whole sequence, so its regmap accesses must not take it again.
+ */
+static void oa_tc6_regmap_lock(void* arg) {
+    struct oa_tc6* tc6 = arg;
+
+    if (READ_ONCE(tc6->ctrl_batch_owner) == current)
+        return;
+
+    mutex_lock(&tc6->spi_ctrl_lock);
+}
+
+static void oa_tc6_regmap_unlock(void* arg) {
+    struct oa_tc6* tc6 = arg;
+
+    if (READ_ONCE(tc6->ctrl_batch_owner) == current)
+        return;
+
+    mutex_unlock(&tc6->spi_ctrl_lock);
+}
+
+static const struct regmap_bus oa_tc6_regmap_bus = {
+    .read = oa_tc6_regmap_read,
+    .write = oa_tc6_regmap_write,
+    .max_raw_read = OA_TC6_CTRL_MAX_REGISTERS * OA_TC6_CTRL_REG_VALUE_SIZE,
+    .max_raw_write = OA_TC6_CTRL_MAX_REGISTERS * OA_TC6_CTRL_REG_VALUE_SIZE,
+};
+
+static const struct regmap_config oa_tc6_regmap_config = {
+    .reg_bits = 32,
+    .val_bits = 32,
+    .reg_stride = 1,
+    .reg_format_endian = REGMAP_ENDIAN_NATIVE,
+    .val_format_endian = REGMAP_ENDIAN_NATIVE,
+    .max_register = OA_TC6_REGMAP_MAX_REGISTER,
+    .lock = oa_tc6_regmap_lock,
+    .unlock = oa_tc6_regmap_unlock,
+    .volatile_table = &oa_tc6_volatile_table,
+    .cache_type = REGCACHE_MAPLE,
+    /* Dumping the whole address space would read every volatile register */
+    .disable_debugfs = true,
+};
+
+static int oa_tc6_regcache_stats_show(struct seq_file* s, void* data) {
+    struct oa_tc6* tc6 = s->private;
+    long reads = atomic_long_read(&tc6->regcache_reads);
+    long misses = atomic_long_read(&tc6->regcache_misses);
+
+    seq_printf(s, "hits: %ld\n", reads - misses);
+    seq_printf(s, "misses: %ld\n", misses);
+    seq_printf(s, "volatile reads: %ld\n", atomic_long_read(&tc6->volatile_reads));
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(oa_tc6_regcache_stats);
+
+static void oa_tc6_debugfs_init(struct oa_tc6* tc6) {
+    char name[32];
+
+    snprintf(name, sizeof(name), "oa_tc6-%s", dev_name(&tc6->spi->dev));
+    tc6->debugfs_dir = debugfs_create_dir(name, NULL);
+    debugfs_create_file("regcache_stats", 0444, tc6->debugfs_dir, tc6, &oa_tc6_regcache_stats_fops);
+}
+
 /**
  * oa_tc6_read_registers - function for reading multiple consecutive registers.
  * @tc6: oa_tc6 struct.
@@ -405,18 +924,20 @@ static int oa_tc6_perform_ctrl(struct oa_tc6* tc6, u32 address, u32 value[], u8
  * Return: 0 on success otherwise failed.
  */
 int oa_tc6_read_registers(struct oa_tc6* tc6, u32 address, u32 value[], u8 length) {
-    int ret;
-
     if (!length || length > OA_TC6_CTRL_MAX_REGISTERS) {
         dev_err(&tc6->spi->dev, "Invalid register length parameter\n");
         return -EINVAL;
     }
 
-    mutex_lock(&tc6->spi_ctrl_lock);
-    ret = oa_tc6_perform_ctrl(tc6, address, value, length, OA_TC6_CTRL_REG_READ);
-    mutex_unlock(&tc6->spi_ctrl_lock);
+    for (int i = 0; i < length; i++) {
+        if (oa_tc6_reg_cached(address + i))
+            atomic_long_inc(&tc6->regcache_reads);
+    }
 
-    return ret;
+    /* Cached registers are served from memory, volatile ones are read from
+     * the MAC-PHY in a single control transaction if possible.
+     */
+    return regmap_bulk_read(tc6->regmap, address, value, length);
 }
 EXPORT_SYMBOL_GPL(oa_tc6_read_registers);
 
@@ -445,18 +966,15 @@ EXPORT_SYMBOL_GPL(oa_tc6_read_register);
  * Return: 0 on success otherwise failed.
  */
 int oa_tc6_write_registers(struct oa_tc6* tc6, u32 address, u32 value[], u8 length) {
-    int ret;
-
     if (!length || length > OA_TC6_CTRL_MAX_REGISTERS) {
         dev_err(&tc6->spi->dev, "Invalid register length parameter\n");
         return -EINVAL;
     }
 
-    mutex_lock(&tc6->spi_ctrl_lock);
-    ret = oa_tc6_perform_ctrl(tc6, address, value, length, OA_TC6_CTRL_REG_WRITE);
-    mutex_unlock(&tc6->spi_ctrl_lock);
-
-    return ret;
+    /* Always written through to the MAC-PHY, cached registers update the
+     * regmap cache as well.
+     */
+    return regmap_bulk_write(tc6->regmap, address, value, length);
 }
 EXPORT_SYMBOL_GPL(oa_tc6_write_registers);
 
@@ -473,6 +991,103 @@ int oa_tc6_write_register(struct oa_tc6* tc6, u32 address, u32 value) {
 }
 EXPORT_SYMBOL_GPL(oa_tc6_write_register);
 
+/**
+ * oa_tc6_write_register_seq - function for writing a sequence of registers.
+ * @tc6: oa_tc6 struct.
+ * @seq: registers and values to be written, in order.
+ * @count: number of entries in @seq.
+ *
+ * Runs of consecutive register addresses are written in a single control
+ * command. All the commands are sent in as few SPI messages as possible
+ * without releasing the control path in between.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_write_register_seq(struct oa_tc6* tc6, const struct oa_tc6_reg_seq seq[], int count) {
+    int ret = 0;
+    int run;
+
+    mutex_lock(&tc6->spi_ctrl_lock);
+    WRITE_ONCE(tc6->ctrl_batch_owner, current);
+
+    for (int i = 0; i < count; i += run) {
+        tc6->ctrl_seq_values[0] = seq[i].value;
+        for (run = 1; i + run < count && run < OA_TC6_CTRL_MAX_REGISTERS; run++) {
+            if (seq[i + run].address != seq[i].address + run)
+                break;
+            tc6->ctrl_seq_values[run] = seq[i + run].value;
+        }
+
+        ret = regmap_bulk_write(tc6->regmap, seq[i].address, tc6->ctrl_seq_values, run);
+        if (ret)
+            break;
+    }
+
+    if (!ret)
+        ret = oa_tc6_flush_ctrl_batch(tc6);
+
+    /* Don't leave commands of a failed sequence for the next one */
+    tc6->no_of_ctrl_batch_xfers = 0;
+    tc6->ctrl_batch_len = 0;
+
+    WRITE_ONCE(tc6->ctrl_batch_owner, NULL);
+    mutex_unlock(&tc6->spi_ctrl_lock);
+
+    /* The cache was updated before the commands were sent, so it is not
+     * known which of them made it into the MAC-PHY.
+     */
+    if (ret) {
+        for (int i = 0; i < count; i++)
+            regcache_drop_region(tc6->regmap, seq[i].address, seq[i].address);
+    }
+
+    return ret;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_write_register_seq);
+
+/**
+ * oa_tc6_register_ts_capture_handler - function for getting notified about
+ * transmit timestamp captures.
+ * @tc6: oa_tc6 struct.
+ * @handler: called with the TTSCAx bits of STATUS0 and the TTSCMx bits of
+ * STATUS1 which are set, NULL to unregister.
+ * @ctx: passed to @handler.
+ *
+ * The transmit timestamp capture available and missed interrupts are
+ * unmasked while a handler is registered. The MAC-PHY then reports a capture
+ * through the extended status bit of the next data footer, so no polling of
+ * STATUS0 is needed. The
+ * handler is called from the SPI thread with a spinlock held and must not
+ * sleep. Once unregistering returns, the handler is no longer running and
+ * won't be called again, so @ctx can be freed.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_register_ts_capture_handler(struct oa_tc6* tc6, oa_tc6_ts_capture_handler_t handler, void* ctx) {
+    u32 regval[2];
+    int ret;
+
+    ret = oa_tc6_read_registers(tc6, OA_TC6_REG_INT_MASK0, regval, ARRAY_SIZE(regval));
+    if (ret)
+        return ret;
+
+    if (handler) {
+        regval[0] &= ~INT_MASK0_TTSCA_MASK;
+        regval[1] &= ~INT_MASK1_TTSCM_MASK;
+    } else {
+        regval[0] |= INT_MASK0_TTSCA_MASK;
+        regval[1] |= INT_MASK1_TTSCM_MASK;
+    }
+
+    spin_lock_bh(&tc6->ts_capture_lock);
+    tc6->ts_capture_ctx = ctx;
+    WRITE_ONCE(tc6->ts_capture_handler, handler);
+    spin_unlock_bh(&tc6->ts_capture_lock);
+
+    return oa_tc6_write_registers(tc6, OA_TC6_REG_INT_MASK0, regval, ARRAY_SIZE(regval));
+}
+EXPORT_SYMBOL_GPL(oa_tc6_register_ts_capture_handler);
+
 static int oa_tc6_check_phy_reg_direct_access_capability(struct oa_tc6* tc6) {
     u32 regval;
     int ret;
@@ -662,6 +1277,9 @@ static int oa_tc6_sw_reset_macphy(struct oa_tc6* tc6) {
     if (ret)
         return -ENODEV;
 
+    /* All the registers are back to their defaults */
+    regcache_drop_region(tc6->regmap, 0, OA_TC6_REGMAP_MAX_REGISTER);
+
     /* Clear the reset complete status */
     return oa_tc6_write_register(tc6, OA_TC6_REG_STATUS0, regval);
 }
@@ -684,6 +1302,37 @@ static int oa_tc6_unmask_macphy_error_interrupts(struct oa_tc6* tc6) {
     return oa_tc6_write_register(tc6, OA_TC6_REG_INT_MASK0, regval);
 }
 
+static u8 oa_tc6_get_chunk_payload_size(struct oa_tc6* tc6) {
+    u32 size = chunk_payload_size;
+
+    /* The device property allows a different size per MAC-PHY */
+    device_property_read_u32(&tc6->spi->dev, "chunk-payload-size", &size);
+
+    if (!is_power_of_2(size) || size < OA_TC6_CHUNK_PAYLOAD_SIZE_MIN || size > OA_TC6_CHUNK_PAYLOAD_SIZE_MAX) {
+        dev_warn(&tc6->spi->dev, "Invalid chunk payload size %u, using %d\n", size, OA_TC6_CHUNK_PAYLOAD_SIZE_MAX);
+        size = OA_TC6_CHUNK_PAYLOAD_SIZE_MAX;
+    }
+
+    return size;
+}
+
+static int oa_tc6_set_chunk_payload_size(struct oa_tc6* tc6) {
+    u32 value;
+    int ret;
+
+    ret = oa_tc6_read_register(tc6, OA_TC6_REG_CONFIG0, &value);
+    if (ret)
+        return ret;
+
+    /* CPS is only taken over with the configuration synchronization, so
+     * it must be written before SYNC is set.
+     */
+    value &= ~CONFIG0_CPS;
+    value |= FIELD_PREP(CONFIG0_CPS, ilog2(tc6->chunk_payload_size));
+
+    return oa_tc6_write_register(tc6, OA_TC6_REG_CONFIG0, value);
+}
+
 static int oa_tc6_enable_data_transfer(struct oa_tc6* tc6) {
     u32 value;
     int ret;
@@ -715,6 +1364,7 @@ static void oa_tc6_cleanup_ongoing_tx_skb(struct oa_tc6* tc6) {
 }
 
 static int oa_tc6_process_extended_status(struct oa_tc6* tc6) {
+    u32 ttsc_missed = 0;
     u32 value;
     int ret;
 
@@ -731,6 +1381,49 @@ static int oa_tc6_process_extended_status(struct oa_tc6* tc6) {
         return ret;
     }
 
+    /* A missed capture is only in STATUS1. The extended status stays set
+     * until it is cleared, so STATUS1 is read only when STATUS0 has no
+     * capture to report. A miss together with a capture is then picked up
+     * with the next footer, without a second read for every capture.
+     */
+    if (!(value & STATUS0_TTSCA) && READ_ONCE(tc6->ts_capture_handler)) {
+        u32 status1;
+
+        ret = oa_tc6_read_register(tc6, OA_TC6_REG_STATUS1, &status1);
+        if (ret) {
+            netdev_err(tc6->netdev, "STATUS1 register read failed: %d\n", ret);
+            return ret;
+        }
+
+        ttsc_missed = status1 & STATUS1_TTSCM;
+        if (ttsc_missed) {
+            ret = oa_tc6_write_register(tc6, OA_TC6_REG_STATUS1, ttsc_missed);
+            if (ret) {
+                netdev_err(tc6->netdev, "STATUS1 register write failed: %d\n", ret);
+                return ret;
+            }
+        }
+    }
+
+    if ((value & STATUS0_TTSCA) || ttsc_missed) {
+        /* The capture registers are only read by the handler, the bits
+         * are cleared already so a new capture raises them again.
+         */
+        spin_lock_bh(&tc6->ts_capture_lock);
+        if (tc6->ts_capture_handler)
+            tc6->ts_capture_handler(tc6->ts_capture_ctx, value & STATUS0_TTSCA, ttsc_missed);
+        spin_unlock_bh(&tc6->ts_capture_lock);
+    }
+
+    /* Only in transmit cut-through mode: the MAC-PHY started sending the
+     * frame before all of it was received over SPI and had to abort it.
+     */
+    if (FIELD_GET(STATUS0_TX_BUFFER_UNDERFLOW_ERROR, value)) {
+        tc6->netdev->stats.tx_errors++;
+        tc6->netdev->stats.tx_fifo_errors++;
+        net_err_ratelimited("%s: Transmit buffer underflow error\n", tc6->netdev->name);
+    }
+
     if (FIELD_GET(STATUS0_RX_BUFFER_OVERFLOW_ERROR, value)) {
         tc6->rx_buf_overflow = true;
         oa_tc6_cleanup_ongoing_rx_skb(tc6);
@@ -789,100 +1482,270 @@ static int oa_tc6_process_rx_chunk_footer(struct oa_tc6* tc6, u32 footer) {
     return 0;
 }
 
+static int oa_tc6_pull_rx_skb_headers(struct sk_buff* skb) {
+    skb_frag_t* frag = &skb_shinfo(skb)->frags[0];
+    unsigned int pull_len;
+
+    if (skb->len < ETH_HLEN)
+        return -EINVAL;
+
+    /* The frame is entirely in page fragments. Copy the protocol headers
+     * into the linear part as expected by eth_type_trans() and the stack,
+     * the rest of the frame stays in the pool page.
+     */
+    pull_len = eth_get_headlen(skb->dev, skb_frag_address(frag),
+                               min_t(unsigned int, skb_frag_size(frag), OA_TC6_RX_HDR_SIZE));
+    pull_len = clamp_t(unsigned int, pull_len, ETH_HLEN, skb->len);
+
+    if (!__pskb_pull_tail(skb, pull_len))
+        return -ENOMEM;
+
+    return 0;
+}
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+/* A 32-bit timestamp only has the 2 LSBs of the seconds. The reference is a
+ * PHC reading at most a resample interval old, so the frame was received
+ * between a second before and two seconds after it.
+ */
+static u32 oa_tc6_extend_rx_ts_seconds(struct oa_tc6* tc6, u32 sec_lsbs) {
+    u32 ref = READ_ONCE(tc6->rx_ts_ref_sec);
+    u32 diff = (sec_lsbs - ref) & FIELD_MAX(OA_TC6_RX_TIMESTAMP32_SECONDS);
+
+    if (diff == FIELD_MAX(OA_TC6_RX_TIMESTAMP32_SECONDS))
+        return ref - 1;
+
+    return ref + diff;
+}
+
+static u64 oa_tc6_get_rx_ts(struct oa_tc6* tc6, const u8* prefix) {
+    u32 seconds, nanoseconds;
+
+    if (rx_timestamp_32bit) {
+        u32 ts = get_unaligned_be32(prefix);
+
+        seconds = oa_tc6_extend_rx_ts_seconds(tc6, FIELD_GET(OA_TC6_RX_TIMESTAMP32_SECONDS, ts));
+        nanoseconds = FIELD_GET(OA_TC6_RX_TIMESTAMP32_NANOSECONDS, ts);
+    } else {
+        seconds = get_unaligned_be32(prefix);
+        nanoseconds = FIELD_GET(OA_TC6_RX_TIMESTAMP32_NANOSECONDS, get_unaligned_be32(prefix + 4));
+    }
+
+    return (u64)seconds * NS_IN_1S + nanoseconds;
+}
+
+/* The MAC-PHY prepends the receive timestamp to the frame and the frame ends
+ * with 4 extra bytes then. Both are removed once the frame is complete, as
+ * with small chunk payloads they may span several chunks.
+ */
+static int oa_tc6_prcs_rx_timestamp(struct oa_tc6* tc6) {
+    u8 headers[ETH_HLEN + VLAN_HLEN + sizeof(struct ptp_header)] = {0};
+    unsigned int ts_size = rx_timestamp_32bit ? OA_TC6_RX_TIMESTAMP32_SIZE : OA_TC6_RX_TIMESTAMP_SIZE;
+    struct sk_buff* skb = tc6->rx_skb;
+    u8 prefix[OA_TC6_RX_TIMESTAMP_SIZE];
+
+    /* Timestamps are only added while FTSE is set */
+    if (!tc6->rx_ts_added)
+        return 0;
+
+    if (skb->len < ts_size + ETH_HLEN + 4)
+        return -EINVAL;
+
+    if (skb_copy_bits(skb, 0, prefix, ts_size))
+        return -EINVAL;
+
+    if (!pskb_pull(skb, ts_size) || pskb_trim(skb, skb->len - 4))
+        return -ENOMEM;
+
+    /* The frame may be in page fragments, the filter needs the headers in
+     * one piece.
+     */
+    if (skb_copy_bits(skb, 0, headers, min_t(unsigned int, skb->len, sizeof(headers))))
+        return -EINVAL;
+
+    if (filter_rx_timestamp(tc6, headers))
+        skb_hwtstamps(skb)->hwtstamp = oa_tc6_get_rx_ts(tc6, prefix);
+
+    return 0;
+}
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
 static void oa_tc6_submit_rx_skb(struct oa_tc6* tc6) {
+    /* Don't let the queue grow without bound if NAPI can't keep up */
+    if (skb_queue_len(&tc6->rx_skb_q) >= OA_TC6_RX_SKB_Q_MAX_LEN) {
+        tc6->netdev->stats.rx_dropped++;
+        kfree_skb(tc6->rx_skb);
+        tc6->rx_skb = NULL;
+        return;
+    }
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+    if (oa_tc6_prcs_rx_timestamp(tc6)) {
+        oa_tc6_cleanup_ongoing_rx_skb(tc6);
+        return;
+    }
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
+    if (tc6->rx_page_pool && oa_tc6_pull_rx_skb_headers(tc6->rx_skb)) {
+        oa_tc6_cleanup_ongoing_rx_skb(tc6);
+        return;
+    }
+
     tc6->rx_skb->protocol = eth_type_trans(tc6->rx_skb, tc6->netdev);
     tc6->netdev->stats.rx_packets++;
     tc6->netdev->stats.rx_bytes += tc6->rx_skb->len;
 
 	//print_hex_dump(KERN_ERR, __func__, DUMP_PREFIX_OFFSET, 16, 1, tc6->rx_skb->data, tc6->rx_skb->len, false);
 
-    netif_rx(tc6->rx_skb);
+    /* Frames are handed to the stack in batches by oa_tc6_napi_poll() */
+    skb_queue_tail(&tc6->rx_skb_q, tc6->rx_skb);
 
     tc6->rx_skb = NULL;
 }
 
+static void oa_tc6_schedule_rx_napi(struct oa_tc6* tc6) {
+    if (skb_queue_empty_lockless(&tc6->rx_skb_q))
+        return;
+
+    /* This is called from the SPI kthread, so disable bottom halves around
+     * the schedule to have the raised softirq run right away.
+     */
+    local_bh_disable();
+    napi_schedule(&tc6->napi);
+    local_bh_enable();
+}
+
+static int oa_tc6_napi_poll(struct napi_struct* napi, int budget) {
+    struct oa_tc6* tc6 = container_of(napi, struct oa_tc6, napi);
+    struct sk_buff* skb;
+    int work_done = 0;
+
+    while (work_done < budget) {
+        skb = skb_dequeue(&tc6->rx_skb_q);
+        if (!skb)
+            break;
+
+        napi_gro_receive(napi, skb);
+        work_done++;
+    }
+
+    if (work_done < budget)
+        napi_complete_done(napi, work_done);
+
+    return work_done;
+}
+
+static void oa_tc6_add_rx_frag(struct oa_tc6* tc6, u8* payload, u8 length) {
+    struct sk_buff* skb = tc6->rx_skb;
+    struct skb_shared_info* shinfo = skb_shinfo(skb);
+    u32 offset = payload - (u8*)page_address(tc6->rx_page);
+    skb_frag_t* frag;
+
+    if (!length)
+        return;
+
+    /* Rx chunk payloads are received back to back into the pool page, so
+     * the chunk usually just extends the previous fragment. A new one is
+     * only needed when the frame continues in a new pool page.
+     */
+    if (shinfo->nr_frags) {
+        frag = &shinfo->frags[shinfo->nr_frags - 1];
+        if (skb_frag_page(frag) == tc6->rx_page && skb_frag_off(frag) + skb_frag_size(frag) == offset) {
+            skb_frag_size_add(frag, length);
+            skb->len += length;
+            skb->data_len += length;
+            skb->truesize += length;
+            return;
+        }
+    }
+
+    /* A pool page holds the payloads of at least one full transfer, so a
+     * frame never spans more than a few pages.
+     */
+    if (WARN_ON_ONCE(shinfo->nr_frags >= MAX_SKB_FRAGS))
+        return;
+
+    tc6->rx_page_frags++;
+    skb_add_rx_frag(skb, shinfo->nr_frags, tc6->rx_page, offset, length, length);
+}
+
 static void oa_tc6_update_rx_skb(struct oa_tc6* tc6, u8* payload, u8 length) {
 	//print_hex_dump(KERN_ERR, __func__, DUMP_PREFIX_OFFSET, 16, 1, payload, length, false);
+    if (tc6->rx_page_pool) {
+        oa_tc6_add_rx_frag(tc6, payload, length);
+        return;
+    }
+
     memcpy(skb_put(tc6->rx_skb, length), payload, length);
 }
 
-static int oa_tc6_allocate_rx_skb(struct oa_tc6* tc6) {
-    tc6->rx_skb = netdev_alloc_skb_ip_align(tc6->netdev, tc6->netdev->mtu + ETH_HLEN + ETH_FCS_LEN);
+static int oa_tc6_allocate_rx_skb(struct oa_tc6* tc6, u32 footer) {
+    /* With the page pool only the headers are copied into the skb */
+    if (tc6->rx_page_pool)
+        tc6->rx_skb = netdev_alloc_skb_ip_align(tc6->netdev, OA_TC6_RX_HDR_SIZE);
+    else
+        tc6->rx_skb = netdev_alloc_skb_ip_align(tc6->netdev, tc6->netdev->mtu + ETH_HLEN + ETH_FCS_LEN +
+                                                                 OA_TC6_RX_TIMESTAMP_SIZE);
     if (!tc6->rx_skb) {
         tc6->netdev->stats.rx_dropped++;
         return -ENOMEM;
     }
 
+    if (tc6->rx_page_pool)
+        skb_mark_for_recycle(tc6->rx_skb);
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+    /* Only valid in the footer of the chunk with the frame start */
+    tc6->rx_ts_added = FIELD_GET(OA_TC6_DATA_FOOTER_RX_TS_ADDED, footer);
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
     return 0;
 }
 
-static int oa_tc6_prcs_complete_rx_frame(struct oa_tc6* tc6, u8* payload, u16 size) {
+static int oa_tc6_prcs_complete_rx_frame(struct oa_tc6* tc6, u8* payload, u16 size, u32 footer) {
     int ret;
 
-    ret = oa_tc6_allocate_rx_skb(tc6);
+    ret = oa_tc6_allocate_rx_skb(tc6, footer);
     if (ret)
         return ret;
 
-#ifdef FRAME_TIMESTAMP_ENABLE
-    if (filter_rx_timestamp(tc6, &payload[sizeof(struct timestamp_format)])) {
-        struct timestamp_format* net_timestamp = (struct timestamp_format*)payload;
-        struct timestamp_format timestamp;
-
-        timestamp.seconds = ntohl(net_timestamp->seconds);
-        timestamp.nanoseconds = ntohl(net_timestamp->nanoseconds);
-
-        skb_hwtstamps(tc6->rx_skb)->hwtstamp = (u64)timestamp.seconds * NS_IN_1S + timestamp.nanoseconds;
-    }
-
-    oa_tc6_update_rx_skb(tc6, &payload[sizeof(struct timestamp_format)], size - sizeof(struct timestamp_format));
-#else /* FRAME_TIMESETAMP_ENABLE */
     oa_tc6_update_rx_skb(tc6, payload, size);
-#endif /* FRAME_TIMESTAMP_ENABLE */
-
     oa_tc6_submit_rx_skb(tc6);
 
     return 0;
 }
 
-static int oa_tc6_prcs_rx_frame_start(struct oa_tc6* tc6, u8* payload, u16 size) {
+static int oa_tc6_prcs_rx_frame_start(struct oa_tc6* tc6, u8* payload, u16 size, u32 footer) {
     int ret;
 
-    ret = oa_tc6_allocate_rx_skb(tc6);
+    ret = oa_tc6_allocate_rx_skb(tc6, footer);
     if (ret)
         return ret;
 
-#ifdef FRAME_TIMESTAMP_ENABLE
-    if (filter_rx_timestamp(tc6, &payload[sizeof(struct timestamp_format)])) {
-        struct timestamp_format* net_timestamp = (struct timestamp_format*)payload;
-        struct timestamp_format timestamp;
-
-        timestamp.seconds = ntohl(net_timestamp->seconds);
-        timestamp.nanoseconds = ntohl(net_timestamp->nanoseconds);
-
-        skb_hwtstamps(tc6->rx_skb)->hwtstamp = (u64)timestamp.seconds * NS_IN_1S + timestamp.nanoseconds;
-    }
-
-    oa_tc6_update_rx_skb(tc6, &payload[sizeof(struct timestamp_format)], size - sizeof(struct timestamp_format));
-#else /* FRAME_TIMESTAMP_ENABLE */
     oa_tc6_update_rx_skb(tc6, payload, size);
-#endif /* FRAME_TIMESTAMP_ENABLE */
 
     return 0;
 }
 
 static void oa_tc6_prcs_rx_frame_end(struct oa_tc6* tc6, u8* payload, u16 size) {
-#ifdef FRAME_TIMESTAMP_ENABLE
-    // NOTE: Remove unnecessary last 4 bytes.
-    oa_tc6_update_rx_skb(tc6, payload, size - 4);
-#else /* FRAME_TIMESTAMP_ENABLE */
     oa_tc6_update_rx_skb(tc6, payload, size);
-#endif /* FRAME_TIMESTAMP_ENABLE */
-
     oa_tc6_submit_rx_skb(tc6);
 }
 
+/* The MAC-PHY found the frame ending in this chunk invalid, e.g. a bad FCS in
+ * receive cut-through mode after the frame start was already handed over.
+ */
+static void oa_tc6_drop_rx_frame(struct oa_tc6* tc6) {
+    tc6->netdev->stats.rx_errors++;
+
+    if (tc6->rx_skb) {
+        kfree_skb(tc6->rx_skb);
+        tc6->rx_skb = NULL;
+    }
+}
+
 static void oa_tc6_prcs_ongoing_rx_frame(struct oa_tc6* tc6, u8* payload, u32 footer) {
-    oa_tc6_update_rx_skb(tc6, payload, OA_TC6_CHUNK_PAYLOAD_SIZE);
+    oa_tc6_update_rx_skb(tc6, payload, tc6->chunk_payload_size);
 }
 
 static int oa_tc6_prcs_rx_chunk_payload(struct oa_tc6* tc6, u8* data, u32 footer) {
@@ -890,6 +1753,7 @@ static int oa_tc6_prcs_rx_chunk_payload(struct oa_tc6* tc6, u8* data, u32 footer
     u8 end_byte_offset = FIELD_GET(OA_TC6_DATA_FOOTER_END_BYTE_OFFSET, footer);
     bool start_valid = FIELD_GET(OA_TC6_DATA_FOOTER_START_VALID, footer);
     bool end_valid = FIELD_GET(OA_TC6_DATA_FOOTER_END_VALID, footer);
+    bool frame_drop = FIELD_GET(OA_TC6_DATA_FOOTER_FRAME_DROP, footer);
     u16 size;
 
     /* Restart the new rx frame after receiving rx buffer overflow error */
@@ -901,18 +1765,26 @@ static int oa_tc6_prcs_rx_chunk_payload(struct oa_tc6* tc6, u8* data, u32 footer
 
     /* Process the chunk with complete rx frame */
     if (start_valid && end_valid && start_byte_offset < end_byte_offset) {
+        if (frame_drop) {
+            oa_tc6_drop_rx_frame(tc6);
+            return 0;
+        }
         size = end_byte_offset + 1 - start_byte_offset;
-        return oa_tc6_prcs_complete_rx_frame(tc6, &data[start_byte_offset], size);
+        return oa_tc6_prcs_complete_rx_frame(tc6, &data[start_byte_offset], size, footer);
     }
 
     /* Process the chunk with only rx frame start */
     if (start_valid && !end_valid) {
-        size = OA_TC6_CHUNK_PAYLOAD_SIZE - start_byte_offset;
-        return oa_tc6_prcs_rx_frame_start(tc6, &data[start_byte_offset], size);
+        size = tc6->chunk_payload_size - start_byte_offset;
+        return oa_tc6_prcs_rx_frame_start(tc6, &data[start_byte_offset], size, footer);
     }
 
     /* Process the chunk with only rx frame end */
     if (end_valid && !start_valid) {
+        if (frame_drop) {
+            oa_tc6_drop_rx_frame(tc6);
+            return 0;
+        }
         size = end_byte_offset + 1;
         oa_tc6_prcs_rx_frame_end(tc6, data, size);
         return 0;
@@ -926,12 +1798,14 @@ static int oa_tc6_prcs_rx_chunk_payload(struct oa_tc6* tc6, u8* data, u32 footer
          * possibility of getting an end valid of a previously
          * incomplete rx frame along with the new rx frame start valid.
          */
-        if (tc6->rx_skb) {
+        if (tc6->rx_skb && frame_drop) {
+            oa_tc6_drop_rx_frame(tc6);
+        } else if (tc6->rx_skb) {
             size = end_byte_offset + 1;
             oa_tc6_prcs_rx_frame_end(tc6, data, size);
         }
-        size = OA_TC6_CHUNK_PAYLOAD_SIZE - start_byte_offset;
-        return oa_tc6_prcs_rx_frame_start(tc6, &data[start_byte_offset], size);
+        size = tc6->chunk_payload_size - start_byte_offset;
+        return oa_tc6_prcs_rx_frame_start(tc6, &data[start_byte_offset], size, footer);
     }
 
     /* Process the chunk with ongoing rx frame data */
@@ -940,24 +1814,34 @@ static int oa_tc6_prcs_rx_chunk_payload(struct oa_tc6* tc6, u8* data, u32 footer
     return 0;
 }
 
-static u32 oa_tc6_get_rx_chunk_footer(struct oa_tc6* tc6, u16 footer_offset) {
+static u32 oa_tc6_get_rx_chunk_footer(struct oa_tc6* tc6, u16 chunk) {
     u8* rx_buf = tc6->spi_data_rx_buf;
     __be32 footer;
 
-    footer = *((__be32*)&rx_buf[footer_offset]);
+    if (tc6->rx_page_pool)
+        return be32_to_cpu(tc6->spi_data_rx_footers[chunk]);
+
+    /* Last 4 bytes in each received chunk consist footer info */
+    footer = *((__be32*)&rx_buf[chunk * tc6->chunk_size + tc6->chunk_payload_size]);
 
     return be32_to_cpu(footer);
 }
 
+static u8* oa_tc6_get_rx_chunk_payload(struct oa_tc6* tc6, u16 chunk) {
+    if (tc6->rx_page_pool)
+        return tc6->rx_chunk_base + chunk * tc6->chunk_payload_size;
+
+    return tc6->spi_data_rx_buf + chunk * tc6->chunk_size;
+}
+
 static int oa_tc6_process_spi_data_rx_buf(struct oa_tc6* tc6, u16 length) {
-    u16 no_of_rx_chunks = length / OA_TC6_CHUNK_SIZE;
+    u16 no_of_rx_chunks = length / tc6->chunk_size;
     u32 footer;
     int ret;
 
     /* All the rx chunks in the receive SPI data buffer are examined here */
     for (int i = 0; i < no_of_rx_chunks; i++) {
-        /* Last 4 bytes in each received chunk consist footer info */
-        footer = oa_tc6_get_rx_chunk_footer(tc6, i * OA_TC6_CHUNK_SIZE + OA_TC6_CHUNK_PAYLOAD_SIZE);
+        footer = oa_tc6_get_rx_chunk_footer(tc6, i);
 
         ret = oa_tc6_process_rx_chunk_footer(tc6, footer);
         if (ret)
@@ -968,25 +1852,158 @@ static int oa_tc6_process_spi_data_rx_buf(struct oa_tc6* tc6, u16 length) {
          * of the receive frame data.
          */
         if (FIELD_GET(OA_TC6_DATA_FOOTER_DATA_VALID, footer)) {
-            u8* payload = tc6->spi_data_rx_buf + i * OA_TC6_CHUNK_SIZE;
+            u8* payload = oa_tc6_get_rx_chunk_payload(tc6, i);
+
+            ret = oa_tc6_prcs_rx_chunk_payload(tc6, payload, footer);
+            if (ret)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+static u32 oa_tc6_tx_ring_count(struct oa_tc6* tc6) {
+    return smp_load_acquire(&tc6->tx_ring_head) - READ_ONCE(tc6->tx_ring_tail);
+}
+
+static bool oa_tc6_tx_ring_empty(struct oa_tc6* tc6) {
+    return !oa_tc6_tx_ring_count(tc6);
+}
+
+static struct oa_tc6_tx_desc* oa_tc6_tx_ring_peek(struct oa_tc6* tc6) {
+    u32 tail = tc6->tx_ring_tail;
+
+    /* Single producer (oa_tc6_start_xmit(), serialized by the netdev tx
+     * lock) and single consumer (SPI kthread), so the acquire/release pairs
+     * on head and tail are enough to hand the skb over without a lock.
+     */
+    if (tail == smp_load_acquire(&tc6->tx_ring_head))
+        return NULL;
+
+    return &tc6->tx_ring[tail & (OA_TC6_TX_RING_MAX_SIZE - 1)];
+}
+
+static void oa_tc6_tx_ring_get_ongoing_tx_skb(struct oa_tc6* tc6) {
+    struct oa_tc6_tx_desc* desc = oa_tc6_tx_ring_peek(tc6);
+
+    if (!desc)
+        return;
+
+    tc6->ongoing_tx_skb = desc->skb;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    tc6->ongoing_tx_ts_capture_mode = desc->ts_capture_mode;
+#endif /* FRAME_TIMESTAMP_ENABLE */
+    desc->skb = NULL;
+
+    smp_store_release(&tc6->tx_ring_tail, tc6->tx_ring_tail + 1);
+}
+
+static void oa_tc6_tx_ring_wake_queue(struct oa_tc6* tc6) {
+    /* Pairs with the barrier in oa_tc6_start_xmit() so that either the
+     * producer sees the new tail or we see the stopped queue.
+     */
+    smp_mb();
+
+    if (netif_queue_stopped(tc6->netdev) && oa_tc6_tx_ring_count(tc6) < READ_ONCE(tc6->tx_ring_size))
+        netif_wake_queue(tc6->netdev);
+}
+
+static void oa_tc6_tx_ring_purge(struct oa_tc6* tc6) {
+    while (!oa_tc6_tx_ring_empty(tc6)) {
+        oa_tc6_tx_ring_get_ongoing_tx_skb(tc6);
+        dev_kfree_skb_any(tc6->ongoing_tx_skb);
+        tc6->ongoing_tx_skb = NULL;
+    }
+}
+
+static void oa_tc6_tx_sg_map(struct oa_tc6* tc6, u8* dst, u8* src, u16 len) {
+    u8* tx_buf = tc6->spi_data_tx_buf;
+    u16 offset = dst - tx_buf;
+
+    /* Short pieces are cheaper to copy than to send as separate transfers.
+     * Copying is also the fallback when the segment table is full, keeping
+     * room for the gap before this piece and the one closing the transfer.
+     */
+    if (len < OA_TC6_TX_SG_MIN_LEN || tc6->no_of_spi_tx_segs + 3 > OA_TC6_MAX_SPI_TX_SEGS) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    /* Chunk headers, padding and copied data come from the tx buffer */
+    oa_tc6_spi_add_seg(tc6->spi_tx_segs, &tc6->no_of_spi_tx_segs, tx_buf + tc6->spi_tx_seg_cursor,
+                       offset - tc6->spi_tx_seg_cursor);
+    oa_tc6_spi_add_seg(tc6->spi_tx_segs, &tc6->no_of_spi_tx_segs, src, len);
+    tc6->spi_tx_seg_cursor = offset + len;
+}
+
+static u8* oa_tc6_get_tx_skb_data(struct sk_buff* skb, u16 offset, u16* len) {
+    struct skb_shared_info* shinfo = skb_shinfo(skb);
+
+    if (offset < skb_headlen(skb)) {
+        *len = skb_headlen(skb) - offset;
+        return skb->data + offset;
+    }
+
+    offset -= skb_headlen(skb);
+
+    for (int i = 0; i < shinfo->nr_frags; i++) {
+        skb_frag_t* frag = &shinfo->frags[i];
+
+        if (offset < skb_frag_size(frag)) {
+            *len = skb_frag_size(frag) - offset;
+            return skb_frag_address(frag) + offset;
+        }
+        offset -= skb_frag_size(frag);
+    }
+
+    return NULL;
+}
+
+static void oa_tc6_copy_tx_skb_data(struct oa_tc6* tc6, u8* dst, struct sk_buff* skb, u16 offset, u16 len) {
+    u16 piece_len;
+    u8* src;
 
-            ret = oa_tc6_prcs_rx_chunk_payload(tc6, payload, footer);
-            if (ret)
-                return ret;
-        }
+    if (!tc6->tx_sg) {
+        memcpy(dst, skb->data + offset, len);
+        return;
     }
 
-    return 0;
+    /* The skb is not linearized in this mode, so map each piece of its
+     * head and page fragments into the SPI transfer.
+     */
+    while (len) {
+        src = oa_tc6_get_tx_skb_data(skb, offset, &piece_len);
+        if (WARN_ON_ONCE(!src))
+            return;
+
+        piece_len = min(piece_len, len);
+        oa_tc6_tx_sg_map(tc6, dst, src, piece_len);
+        dst += piece_len;
+        offset += piece_len;
+        len -= piece_len;
+    }
+}
+
+static void oa_tc6_free_sent_tx_skb(struct oa_tc6* tc6, struct sk_buff* skb) {
+    /* The skb data may still be mapped into the ongoing SPI transfer */
+    if (tc6->tx_sg)
+        __skb_queue_tail(&tc6->tx_done_q, skb);
+    else
+        kfree_skb(skb);
 }
 
 #ifdef FRAME_TIMESTAMP_ENABLE
-static __be32 oa_tc6_prepare_data_header(bool data_valid, bool start_valid, bool end_valid, u8 end_byte_offset, u8 ts_capture_mode) {
+static __be32 oa_tc6_prepare_data_header(bool data_valid, bool start_valid, u8 start_word_offset, bool end_valid,
+                                         u8 end_byte_offset, u8 ts_capture_mode) {
 #else /* FRAME_TIMESTAMP_ENABLE */
-static __be32 oa_tc6_prepare_data_header(bool data_valid, bool start_valid, bool end_valid, u8 end_byte_offset) {
+static __be32 oa_tc6_prepare_data_header(bool data_valid, bool start_valid, u8 start_word_offset, bool end_valid,
+                                         u8 end_byte_offset) {
 #endif /* FRAME_TIMESTAMP_ENABLE */
     u32 header = FIELD_PREP(OA_TC6_DATA_HEADER_DATA_NOT_CTRL, OA_TC6_DATA_HEADER) |
                  FIELD_PREP(OA_TC6_DATA_HEADER_DATA_VALID, data_valid) |
                  FIELD_PREP(OA_TC6_DATA_HEADER_START_VALID, start_valid) |
+                 FIELD_PREP(OA_TC6_DATA_HEADER_START_WORD_OFFSET, start_word_offset) |
                  FIELD_PREP(OA_TC6_DATA_HEADER_END_VALID, end_valid) |
                  FIELD_PREP(OA_TC6_DATA_HEADER_END_BYTE_OFFSET, end_byte_offset);
 #ifdef FRAME_TIMESTAMP_ENABLE
@@ -998,12 +2015,51 @@ static __be32 oa_tc6_prepare_data_header(bool data_valid, bool start_valid, bool
     return cpu_to_be32(header);
 }
 
+static bool oa_tc6_pack_next_tx_skb(struct oa_tc6* tc6, u8* payload, u8 used_len, u8* start_word_offset) {
+    u8 start_byte_offset = round_up(used_len, sizeof(u32));
+    struct oa_tc6_tx_desc* desc;
+    u8 length_to_copy;
+
+    if (!tx_chunk_packing || start_byte_offset >= tc6->chunk_payload_size)
+        return false;
+
+    desc = oa_tc6_tx_ring_peek(tc6);
+    if (!desc)
+        return false;
+
+    length_to_copy = tc6->chunk_payload_size - start_byte_offset;
+
+    /* A chunk can only carry one frame end, so the packed frame must
+     * continue in the next chunk.
+     */
+    if (desc->skb->len <= length_to_copy)
+        return false;
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+    /* The header has a single time stamp capture field which is already
+     * taken by the frame ending in this chunk.
+     */
+    if (desc->ts_capture_mode)
+        return false;
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
+    oa_tc6_tx_ring_get_ongoing_tx_skb(tc6);
+
+    /* Software tx timestamp when the frame starts going out on SPI */
+    skb_tx_timestamp(tc6->ongoing_tx_skb);
+    oa_tc6_copy_tx_skb_data(tc6, &payload[start_byte_offset], tc6->ongoing_tx_skb, 0, length_to_copy);
+    tc6->tx_skb_offset = length_to_copy;
+    *start_word_offset = start_byte_offset / sizeof(u32);
+
+    return true;
+}
+
 static void oa_tc6_add_tx_skb_to_spi_buf(struct oa_tc6* tc6) {
     enum oa_tc6_data_end_valid_info end_valid = OA_TC6_DATA_END_INVALID;
     __be32* tx_buf = tc6->spi_data_tx_buf + tc6->spi_data_tx_buf_offset;
     u16 remaining_len = tc6->ongoing_tx_skb->len - tc6->tx_skb_offset;
-    u8* tx_skb_data = tc6->ongoing_tx_skb->data + tc6->tx_skb_offset;
     enum oa_tc6_data_start_valid_info start_valid;
+    u8 start_word_offset = 0;
     u8 end_byte_offset = 0;
     u16 length_to_copy;
 #ifdef FRAME_TIMESTAMP_ENABLE
@@ -1018,17 +2074,20 @@ static void oa_tc6_add_tx_skb_to_spi_buf(struct oa_tc6* tc6) {
     /* Set start valid if the current tx chunk contains the start of the tx
      * ethernet frame.
      */
-    if (!tc6->tx_skb_offset)
+    if (!tc6->tx_skb_offset) {
         start_valid = OA_TC6_DATA_START_VALID;
+        /* Software tx timestamp when the frame starts going out on SPI */
+        skb_tx_timestamp(tc6->ongoing_tx_skb);
+    }
 
-    /* If the remaining tx skb length is more than the chunk payload size of
-     * 64 bytes then copy only 64 bytes and leave the ongoing tx skb for
+    /* If the remaining tx skb length is more than the chunk payload size
+     * then copy only one chunk payload and leave the ongoing tx skb for
      * next tx chunk.
      */
-    length_to_copy = min_t(u16, remaining_len, OA_TC6_CHUNK_PAYLOAD_SIZE);
+    length_to_copy = min_t(u16, remaining_len, tc6->chunk_payload_size);
 
     /* Copy the tx skb data to the tx chunk payload buffer */
-    memcpy(tx_buf + 1, tx_skb_data, length_to_copy);
+    oa_tc6_copy_tx_skb_data(tc6, (u8*)(tx_buf + 1), tc6->ongoing_tx_skb, tc6->tx_skb_offset, length_to_copy);
     tc6->tx_skb_offset += length_to_copy;
 
     /* Set end valid if the current tx chunk contains the end of the tx
@@ -1040,113 +2099,140 @@ static void oa_tc6_add_tx_skb_to_spi_buf(struct oa_tc6* tc6) {
         tc6->tx_skb_offset = 0;
         tc6->netdev->stats.tx_bytes += tc6->ongoing_tx_skb->len;
         tc6->netdev->stats.tx_packets++;
-		kfree_skb(tc6->ongoing_tx_skb);
+        oa_tc6_free_sent_tx_skb(tc6, tc6->ongoing_tx_skb);
         tc6->ongoing_tx_skb = NULL;
 #ifdef FRAME_TIMESTAMP_ENABLE
         ts_capture_mode = tc6->ongoing_tx_ts_capture_mode;
         tc6->ongoing_tx_ts_capture_mode = 0;
 #endif /* FRAME_TIMESTAMP_ENABLE */
+
+        /* Start the next tx frame in the remaining chunk payload instead
+         * of padding it. Only one frame start is allowed per chunk, so
+         * this is done only if the ended frame started in an earlier one.
+         */
+#ifdef FRAME_TIMESTAMP_ENABLE
+        if (!start_valid && !ts_capture_mode &&
+            oa_tc6_pack_next_tx_skb(tc6, (u8*)(tx_buf + 1), length_to_copy, &start_word_offset))
+#else  /* FRAME_TIMESTAMP_ENABLE */
+        if (!start_valid && oa_tc6_pack_next_tx_skb(tc6, (u8*)(tx_buf + 1), length_to_copy, &start_word_offset))
+#endif /* FRAME_TIMESTAMP_ENABLE */
+            start_valid = OA_TC6_DATA_START_VALID;
     }
 
 #ifdef FRAME_TIMESTAMP_ENABLE
-    *tx_buf = oa_tc6_prepare_data_header(OA_TC6_DATA_VALID, start_valid, end_valid, end_byte_offset, ts_capture_mode);
+    *tx_buf = oa_tc6_prepare_data_header(OA_TC6_DATA_VALID, start_valid, start_word_offset, end_valid, end_byte_offset,
+                                         ts_capture_mode);
 #else /* FRAME_TIMESTAMP_ENABLE */
-    *tx_buf = oa_tc6_prepare_data_header(OA_TC6_DATA_VALID, start_valid, end_valid, end_byte_offset);
+    *tx_buf = oa_tc6_prepare_data_header(OA_TC6_DATA_VALID, start_valid, start_word_offset, end_valid, end_byte_offset);
 #endif /* FRAME_TIMESTAMP_ENABLE */
-    tc6->spi_data_tx_buf_offset += OA_TC6_CHUNK_SIZE;
+    tc6->spi_data_tx_buf_offset += tc6->chunk_size;
 }
 
 static u16 oa_tc6_prepare_spi_tx_buf_for_tx_skbs(struct oa_tc6* tc6) {
     u16 used_tx_credits;
 
-    /* Get tx skbs and convert them into tx chunks based on the tx credits
-     * available.
+    /* Get tx skbs from the tx ring and convert them into tx chunks until
+     * the tx credits available are used up, so that one spi transfer can
+     * carry several back-to-back frames.
      */
     for (used_tx_credits = 0; used_tx_credits < tc6->tx_credits; used_tx_credits++) {
-        if (!tc6->ongoing_tx_skb) {
-            spin_lock_bh(&tc6->tx_skb_lock);
-            tc6->ongoing_tx_skb = tc6->waiting_tx_skb;
-            tc6->waiting_tx_skb = NULL;
-#ifdef FRAME_TIMESTAMP_ENABLE
-            tc6->ongoing_tx_ts_capture_mode = tc6->waiting_tx_ts_capture_mode;
-            tc6->waiting_tx_ts_capture_mode = 0;
-#endif /* FRAME_TIMESTAMP_ENABLE */
-            spin_unlock_bh(&tc6->tx_skb_lock);
-        }
+        if (!tc6->ongoing_tx_skb)
+            oa_tc6_tx_ring_get_ongoing_tx_skb(tc6);
         if (!tc6->ongoing_tx_skb)
             break;
         oa_tc6_add_tx_skb_to_spi_buf(tc6);
     }
 
-    return used_tx_credits * OA_TC6_CHUNK_SIZE;
+    return used_tx_credits * tc6->chunk_size;
 }
 
 static void oa_tc6_add_empty_chunks_to_spi_buf(struct oa_tc6* tc6, u16 needed_empty_chunks) {
     __be32 header;
 
 #ifdef FRAME_TIMESTAMP_ENABLE
-    header = oa_tc6_prepare_data_header(OA_TC6_DATA_INVALID, OA_TC6_DATA_START_INVALID, OA_TC6_DATA_END_INVALID, 0, 0);
+    header =
+        oa_tc6_prepare_data_header(OA_TC6_DATA_INVALID, OA_TC6_DATA_START_INVALID, 0, OA_TC6_DATA_END_INVALID, 0, 0);
 #else /* FRAME_TIMETAMP_ENABLE */
-    header = oa_tc6_prepare_data_header(OA_TC6_DATA_INVALID, OA_TC6_DATA_START_INVALID, OA_TC6_DATA_END_INVALID, 0);
+    header = oa_tc6_prepare_data_header(OA_TC6_DATA_INVALID, OA_TC6_DATA_START_INVALID, 0, OA_TC6_DATA_END_INVALID, 0);
 #endif /* FRAME_TIMESTAMP_ENABLE */
 
     while (needed_empty_chunks--) {
         __be32* tx_buf = tc6->spi_data_tx_buf + tc6->spi_data_tx_buf_offset;
 
         *tx_buf = header;
-        tc6->spi_data_tx_buf_offset += OA_TC6_CHUNK_SIZE;
+        tc6->spi_data_tx_buf_offset += tc6->chunk_size;
     }
 }
 
 static u16 oa_tc6_prepare_spi_tx_buf_for_rx_chunks(struct oa_tc6* tc6, u16 len) {
-    u16 tx_chunks = len / OA_TC6_CHUNK_SIZE;
+    u16 rx_chunks = min_t(u16, tc6->rx_chunks_available, OA_TC6_MAX_TX_CHUNKS);
+    u16 tx_chunks = len / tc6->chunk_size;
     u16 needed_empty_chunks;
 
     /* If there are more chunks to receive than to transmit, we need to add
      * enough empty tx chunks to allow the reception of the excess rx
      * chunks.
      */
-    if (tx_chunks >= tc6->rx_chunks_available)
+    if (tx_chunks >= rx_chunks)
         return len;
 
-    needed_empty_chunks = tc6->rx_chunks_available - tx_chunks;
+    needed_empty_chunks = rx_chunks - tx_chunks;
 
     oa_tc6_add_empty_chunks_to_spi_buf(tc6, needed_empty_chunks);
 
-    return needed_empty_chunks * OA_TC6_CHUNK_SIZE + len;
+    return needed_empty_chunks * tc6->chunk_size + len;
 }
 
-static int oa_tc6_try_spi_transfer(struct oa_tc6* tc6) {
-    int ret;
+static u16 oa_tc6_prepare_spi_data_tx_buf(struct oa_tc6* tc6, u16* tx_chunks) {
+    u16 spi_len = 0;
 
-    while (true) {
-        u16 spi_len = 0;
+    tc6->spi_data_tx_buf_offset = 0;
+    tc6->no_of_spi_tx_segs = 0;
+    tc6->spi_tx_seg_cursor = 0;
 
-        tc6->spi_data_tx_buf_offset = 0;
+    if (tc6->ongoing_tx_skb || !oa_tc6_tx_ring_empty(tc6))
+        spi_len = oa_tc6_prepare_spi_tx_buf_for_tx_skbs(tc6);
 
-        if (tc6->ongoing_tx_skb || tc6->waiting_tx_skb)
-            spi_len = oa_tc6_prepare_spi_tx_buf_for_tx_skbs(tc6);
+    *tx_chunks = spi_len / tc6->chunk_size;
 
-        spi_len = oa_tc6_prepare_spi_tx_buf_for_rx_chunks(tc6, spi_len);
+    spi_len = oa_tc6_prepare_spi_tx_buf_for_rx_chunks(tc6, spi_len);
 
-        if (tc6->int_flag) {
-            tc6->int_flag = false;
-            if (spi_len == 0) {
-                oa_tc6_add_empty_chunks_to_spi_buf(tc6, 1);
-                spi_len = OA_TC6_CHUNK_SIZE;
-            }
+    if (tc6->int_flag) {
+        tc6->int_flag = false;
+        if (spi_len == 0) {
+            oa_tc6_add_empty_chunks_to_spi_buf(tc6, 1);
+            spi_len = tc6->chunk_size;
         }
+    }
+
+    return spi_len;
+}
+
+static int oa_tc6_try_spi_transfer(struct oa_tc6* tc6) {
+    u16 tx_chunks;
+    int ret;
+
+    while (true) {
+        u16 spi_len = oa_tc6_prepare_spi_data_tx_buf(tc6, &tx_chunks);
 
         if (spi_len == 0)
             break;
 
-        ret = oa_tc6_spi_transfer(tc6, OA_TC6_DATA_HEADER, spi_len);
+        ret = oa_tc6_spi_data_transfer(tc6, spi_len);
+
+        /* Sent tx skbs are not mapped to the SPI transfer anymore */
+        __skb_queue_purge(&tc6->tx_done_q);
+
         if (ret) {
             netdev_err(tc6->netdev, "SPI data transfer failed: %d\n", ret);
             return ret;
         }
 
         ret = oa_tc6_process_spi_data_rx_buf(tc6, spi_len);
+
+        /* Deliver all the rx frames completed in this transfer at once */
+        oa_tc6_schedule_rx_napi(tc6);
+
         if (ret) {
             if (ret == -EAGAIN)
                 continue;
@@ -1157,10 +2243,138 @@ static int oa_tc6_try_spi_transfer(struct oa_tc6* tc6) {
             return ret;
         }
 
-        if (!tc6->waiting_tx_skb && netif_queue_stopped(tc6->netdev))
-            netif_wake_queue(tc6->netdev);
+        oa_tc6_tx_ring_wake_queue(tc6);
+    }
+
+    return 0;
+}
+
+static void oa_tc6_spi_data_buf_complete(void* context) {
+    struct oa_tc6_spi_data_buf* buf = context;
+
+    complete(&buf->done);
+}
+
+static int oa_tc6_finish_spi_data_buf(struct oa_tc6* tc6, struct oa_tc6_spi_data_buf* buf) {
+    int ret;
+
+    wait_for_completion(&buf->done);
+
+    ret = buf->msg.status;
+    if (ret) {
+        netdev_err(tc6->netdev, "SPI data transfer failed: %d\n", ret);
+        return ret;
+    }
+
+    tc6->spi_data_rx_buf = buf->rx_buf;
+    ret = oa_tc6_process_spi_data_rx_buf(tc6, buf->len);
+
+    /* Deliver all the rx frames completed in this transfer at once */
+    oa_tc6_schedule_rx_napi(tc6);
+
+    if (ret && ret != -EAGAIN) {
+        oa_tc6_cleanup_ongoing_tx_skb(tc6);
+        oa_tc6_cleanup_ongoing_rx_skb(tc6);
+        netdev_err(tc6->netdev, "Device error: %d\n", ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int oa_tc6_try_spi_transfer_pipelined(struct oa_tc6* tc6) {
+    struct oa_tc6_spi_data_buf* prev = NULL;
+    struct oa_tc6_spi_data_buf* cur;
+    int next = 0;
+    int ret;
+
+    /* Transfer N+1 is prepared and started before transfer N is parsed, so
+     * the SPI bus is busy while the rx chunks of N are processed.
+     */
+    while (true) {
+        u16 tx_chunks;
+        u16 spi_len;
+
+        cur = &tc6->spi_data_bufs[next];
+        tc6->spi_data_tx_buf = cur->tx_buf;
+
+        /* Credits and rx chunks come from the footers of the last completed
+         * transfer, which don't account for the one still on the wire.
+         */
+        if (prev) {
+            tc6->tx_credits -= min(tc6->tx_credits, prev->tx_chunks);
+            tc6->rx_chunks_available -= min_t(u16, tc6->rx_chunks_available, prev->len / tc6->chunk_size);
+        }
+
+        spi_len = oa_tc6_prepare_spi_data_tx_buf(tc6, &tx_chunks);
+        if (spi_len == 0 && !prev)
+            break;
+
+        if (spi_len) {
+            cur->len = spi_len;
+            cur->tx_chunks = tx_chunks;
+            cur->xfer.len = spi_len;
+            reinit_completion(&cur->done);
+
+            ret = spi_async(tc6->spi, &cur->msg);
+            if (ret) {
+                netdev_err(tc6->netdev, "SPI data transfer failed: %d\n", ret);
+                if (prev)
+                    wait_for_completion(&prev->done);
+                return ret;
+            }
+        }
+
+        if (prev) {
+            ret = oa_tc6_finish_spi_data_buf(tc6, prev);
+            if (ret) {
+                if (spi_len)
+                    wait_for_completion(&cur->done);
+                return ret;
+            }
+
+            oa_tc6_tx_ring_wake_queue(tc6);
+        }
+
+        if (spi_len) {
+            prev = cur;
+            next ^= 1;
+        } else {
+            prev = NULL;
+        }
+    }
+
+    return 0;
+}
+
+static int oa_tc6_spi_pipeline_init(struct oa_tc6* tc6) {
+    struct oa_tc6_spi_data_buf* buf;
+
+    /* The first buffer pair is the one of the synchronous mode */
+    tc6->spi_data_bufs[0].tx_buf = tc6->spi_data_tx_buf;
+    tc6->spi_data_bufs[0].rx_buf = tc6->spi_data_rx_buf;
+
+    tc6->spi_data_bufs[1].tx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE(tc6), GFP_KERNEL);
+    if (!tc6->spi_data_bufs[1].tx_buf)
+        return -ENOMEM;
+
+    tc6->spi_data_bufs[1].rx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE(tc6), GFP_KERNEL);
+    if (!tc6->spi_data_bufs[1].rx_buf)
+        return -ENOMEM;
+
+    for (int i = 0; i < ARRAY_SIZE(tc6->spi_data_bufs); i++) {
+        buf = &tc6->spi_data_bufs[i];
+        buf->xfer.tx_buf = buf->tx_buf;
+        buf->xfer.rx_buf = buf->rx_buf;
+        spi_message_init(&buf->msg);
+        spi_message_add_tail(&buf->xfer, &buf->msg);
+        buf->msg.complete = oa_tc6_spi_data_buf_complete;
+        buf->msg.context = buf;
+        init_completion(&buf->done);
     }
 
+    tc6->spi_pipeline = true;
+
     return 0;
 }
 
@@ -1173,12 +2387,16 @@ static int oa_tc6_spi_thread_handler(void* data) {
          * interrupt to perform spi transfer with tx chunks.
          */
         wait_event_interruptible(tc6->spi_wq,
-                                 tc6->int_flag || (tc6->waiting_tx_skb && tc6->tx_credits) || kthread_should_stop());
+                                 tc6->int_flag || (!oa_tc6_tx_ring_empty(tc6) && tc6->tx_credits) ||
+                                     kthread_should_stop());
 
         if (kthread_should_stop())
             break;
 
-        ret = oa_tc6_try_spi_transfer(tc6);
+        if (tc6->spi_pipeline)
+            ret = oa_tc6_try_spi_transfer_pipelined(tc6);
+        else
+            ret = oa_tc6_try_spi_transfer(tc6);
         if (ret)
             return ret;
     }
@@ -1198,8 +2416,9 @@ static int oa_tc6_update_buffer_status_from_register(struct oa_tc6* tc6) {
     if (ret)
         return ret;
 
-    tc6->tx_credits = FIELD_GET(BUFFER_STATUS_TX_CREDITS_AVAILABLE, value);
-    tc6->rx_chunks_available = FIELD_GET(BUFFER_STATUS_RX_CHUNKS_AVAILABLE, value);
+    /* The 8-bit counts exceed the spi buffers with small chunk payloads */
+    tc6->tx_credits = min_t(u16, FIELD_GET(BUFFER_STATUS_TX_CREDITS_AVAILABLE, value), OA_TC6_MAX_TX_CHUNKS);
+    tc6->rx_chunks_available = min_t(u16, FIELD_GET(BUFFER_STATUS_RX_CHUNKS_AVAILABLE, value), OA_TC6_MAX_TX_CHUNKS);
 
     return 0;
 }
@@ -1243,35 +2462,152 @@ int oa_tc6_zero_align_receive_frame_enable(struct oa_tc6* tc6) {
 }
 EXPORT_SYMBOL_GPL(oa_tc6_zero_align_receive_frame_enable);
 
+/**
+ * oa_tc6_set_cut_through - function to select cut-through or store and
+ * forward mode for each direction.
+ * @tc6: oa_tc6 struct.
+ * @tx: transmit cut-through, frames go on the wire before they are fully
+ * received over SPI.
+ * @rx: receive cut-through, frames are offered to the host before they are
+ * fully received from the wire. Frames found invalid at the end are dropped
+ * through the footer frame drop bit then.
+ *
+ * The MAC transmitter and receiver should be disabled while changing this.
+ * The transmit buffer underflow interrupt is unmasked with tx cut-through,
+ * underflows are counted as tx fifo errors.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_set_cut_through(struct oa_tc6* tc6, bool tx, bool rx) {
+    u32 regval;
+    int ret;
+
+    ret = oa_tc6_read_register(tc6, OA_TC6_REG_INT_MASK0, &regval);
+    if (ret)
+        return ret;
+
+    if (tx)
+        regval &= ~INT_MASK0_TX_BUFFER_UNDERFLOW_ERR_MASK;
+    else
+        regval |= INT_MASK0_TX_BUFFER_UNDERFLOW_ERR_MASK;
+
+    ret = oa_tc6_write_register(tc6, OA_TC6_REG_INT_MASK0, regval);
+    if (ret)
+        return ret;
+
+    ret = oa_tc6_read_register(tc6, OA_TC6_REG_CONFIG0, &regval);
+    if (ret)
+        return ret;
+
+    regval &= ~(CONFIG0_TXCTE | CONFIG0_RXCTE);
+    if (tx)
+        regval |= CONFIG0_TXCTE;
+    if (rx)
+        regval |= CONFIG0_RXCTE;
+
+    return oa_tc6_write_register(tc6, OA_TC6_REG_CONFIG0, regval);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_cut_through);
+
+#ifdef FRAME_TIMESTAMP_ENABLE
+/**
+ * oa_tc6_set_rx_timestamp - function to enable or disable the receive frame
+ * timestamps prepended by the MAC-PHY.
+ * @tc6: oa_tc6 struct.
+ * @enable: true to have the MAC-PHY timestamp the received frames.
+ *
+ * Without timestamps every received frame is 12 bytes (8 with the 32-bit
+ * format) shorter on the SPI.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_set_rx_timestamp(struct oa_tc6* tc6, bool enable) {
+    u32 regval;
+    int ret;
+
+    ret = oa_tc6_read_register(tc6, OA_TC6_REG_CONFIG0, &regval);
+    if (ret)
+        return ret;
+
+    if (enable)
+        regval |= CONFIG0_FTSE;
+    else
+        regval &= ~CONFIG0_FTSE;
+
+    return oa_tc6_write_register(tc6, OA_TC6_REG_CONFIG0, regval);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_rx_timestamp);
+
+/**
+ * oa_tc6_set_rx_ts_filter - function to select the received frames whose
+ * timestamp is passed up with them.
+ * @tc6: oa_tc6 struct.
+ * @rx_filter: HWTSTAMP_FILTER_* value of the hardware timestamping config.
+ */
+void oa_tc6_set_rx_ts_filter(struct oa_tc6* tc6, int rx_filter) {
+    WRITE_ONCE(tc6->rx_ts_filter, rx_filter);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_rx_ts_filter);
+
+/**
+ * oa_tc6_set_rx_ts_reference - function to update the PHC time used to extend
+ * the seconds of 32-bit receive timestamps.
+ * @tc6: oa_tc6 struct.
+ * @phc_ns: PHC time in nanoseconds, must be refreshed at least every second.
+ */
+void oa_tc6_set_rx_ts_reference(struct oa_tc6* tc6, u64 phc_ns) {
+    WRITE_ONCE(tc6->rx_ts_ref_sec, div_u64(phc_ns, NS_IN_1S));
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_rx_ts_reference);
+#endif /* FRAME_TIMESTAMP_ENABLE */
+
 /**
  * oa_tc6_start_xmit - function for sending the tx skb which consists ethernet
  * frame.
  * @tc6: oa_tc6 struct.
  * @skb: socket buffer in which the ethernet frame is stored.
  *
- * Return: NETDEV_TX_OK if the transmit ethernet frame skb added in the tx_skb_q
- * otherwise returns NETDEV_TX_BUSY.
+ * Return: NETDEV_TX_OK if the transmit ethernet frame skb added in the tx ring,
+ * NET_XMIT_DROP if the skb was dropped and freed, otherwise returns
+ * NETDEV_TX_BUSY. The caller must return NETDEV_TX_OK for a dropped skb.
  */
 #ifdef FRAME_TIMESTAMP_ENABLE
 netdev_tx_t oa_tc6_start_xmit(struct oa_tc6* tc6, struct sk_buff* skb, u8 ts_capture_mode) {
 #else /* FRAME_TIMESTAMP_ENABLE */
 netdev_tx_t oa_tc6_start_xmit(struct oa_tc6* tc6, struct sk_buff* skb) {
 #endif /* FRAME_TIMESTAMP_ENABLE */
-    if (tc6->waiting_tx_skb) {
+    u32 ring_size = READ_ONCE(tc6->tx_ring_size);
+    u32 head = tc6->tx_ring_head;
+    struct oa_tc6_tx_desc* desc;
+
+    if (head - smp_load_acquire(&tc6->tx_ring_tail) >= ring_size) {
         netif_stop_queue(tc6->netdev);
         return NETDEV_TX_BUSY;
     }
 
-    if (skb_linearize(skb)) {
+    if (!tc6->tx_sg && skb_linearize(skb)) {
         dev_kfree_skb_any(skb);
         tc6->netdev->stats.tx_dropped++;
-        return NETDEV_TX_OK;
+        return NET_XMIT_DROP;
     }
 
-    spin_lock_bh(&tc6->tx_skb_lock);
-    tc6->waiting_tx_skb = skb;
-    tc6->waiting_tx_ts_capture_mode = ts_capture_mode;
-    spin_unlock_bh(&tc6->tx_skb_lock);
+    desc = &tc6->tx_ring[head & (OA_TC6_TX_RING_MAX_SIZE - 1)];
+    desc->skb = skb;
+#ifdef FRAME_TIMESTAMP_ENABLE
+    desc->ts_capture_mode = ts_capture_mode;
+#endif /* FRAME_TIMESTAMP_ENABLE */
+    smp_store_release(&tc6->tx_ring_head, head + 1);
+
+    /* Stop the queue as soon as the ring is full instead of bouncing the
+     * next frame with NETDEV_TX_BUSY. The kthread may have drained the ring
+     * in the meantime without seeing the stopped queue, so check again.
+     */
+    if (head + 1 - READ_ONCE(tc6->tx_ring_tail) >= ring_size) {
+        netif_stop_queue(tc6->netdev);
+        smp_mb();
+        if (head + 1 - READ_ONCE(tc6->tx_ring_tail) < ring_size)
+            netif_start_queue(tc6->netdev);
+    }
 
     /* Wake spi kthread to perform spi transfer */
     wake_up_interruptible(&tc6->spi_wq);
@@ -1280,6 +2616,90 @@ netdev_tx_t oa_tc6_start_xmit(struct oa_tc6* tc6, struct sk_buff* skb) {
 }
 EXPORT_SYMBOL_GPL(oa_tc6_start_xmit);
 
+/**
+ * oa_tc6_get_tx_ring_param - function to get the tx ring depth.
+ * @tc6: oa_tc6 struct.
+ * @size: current tx ring depth.
+ * @max_size: maximum supported tx ring depth.
+ */
+void oa_tc6_get_tx_ring_param(struct oa_tc6* tc6, u32* size, u32* max_size) {
+    *size = READ_ONCE(tc6->tx_ring_size);
+    *max_size = OA_TC6_TX_RING_MAX_SIZE;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_tx_ring_param);
+
+/**
+ * oa_tc6_set_tx_ring_size - function to set the tx ring depth.
+ * @tc6: oa_tc6 struct.
+ * @size: new tx ring depth.
+ *
+ * The ring storage is allocated for the maximum depth, so the depth can be
+ * changed at any time. Frames already queued beyond a reduced depth are
+ * still transmitted before the queue is woken up again.
+ *
+ * Return: 0 on success otherwise failed.
+ */
+int oa_tc6_set_tx_ring_size(struct oa_tc6* tc6, u32 size) {
+    if (size < OA_TC6_TX_RING_MIN_SIZE || size > OA_TC6_TX_RING_MAX_SIZE)
+        return -EINVAL;
+
+    WRITE_ONCE(tc6->tx_ring_size, size);
+    oa_tc6_tx_ring_wake_queue(tc6);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(oa_tc6_set_tx_ring_size);
+
+/**
+ * oa_tc6_get_tx_backlog - function to get the number of frames waiting in the
+ * tx ring.
+ * @tc6: oa_tc6 struct.
+ *
+ * The frame being transferred to the MAC-PHY is not counted.
+ *
+ * Return: number of queued tx frames.
+ */
+u32 oa_tc6_get_tx_backlog(struct oa_tc6* tc6) {
+    return oa_tc6_tx_ring_count(tc6);
+}
+EXPORT_SYMBOL_GPL(oa_tc6_get_tx_backlog);
+
+static int oa_tc6_rx_page_pool_init(struct oa_tc6* tc6) {
+    struct page_pool_params pp_params = {
+        .flags = PP_FLAG_PAGE_FRAG,
+        .order = 0,
+        .pool_size = OA_TC6_RX_PAGE_POOL_SIZE,
+        .nid = NUMA_NO_NODE,
+        .dev = &tc6->spi->dev,
+    };
+    struct page_pool* pool;
+
+    /* Each pool page must hold the payloads of a complete transfer */
+    BUILD_BUG_ON(OA_TC6_MAX_TX_CHUNKS * OA_TC6_CHUNK_PAYLOAD_SIZE_MAX > PAGE_SIZE);
+
+    tc6->spi_data_rx_footers =
+        devm_kcalloc(&tc6->spi->dev, OA_TC6_MAX_TX_CHUNKS, sizeof(*tc6->spi_data_rx_footers), GFP_KERNEL);
+    if (!tc6->spi_data_rx_footers)
+        return -ENOMEM;
+
+    pool = page_pool_create(&pp_params);
+    if (IS_ERR(pool))
+        return PTR_ERR(pool);
+
+    tc6->rx_page_pool = pool;
+
+    return 0;
+}
+
+static void oa_tc6_rx_page_pool_exit(struct oa_tc6* tc6) {
+    if (!tc6->rx_page_pool)
+        return;
+
+    oa_tc6_rx_page_release(tc6);
+    page_pool_destroy(tc6->rx_page_pool);
+    tc6->rx_page_pool = NULL;
+}
+
 // TODO: Cleanup
 #ifdef FRAME_TIMESTAMP_ENABLE
 
@@ -1382,7 +2802,27 @@ u8 indirect_read(struct oa_tc6* tc6, u8 addr, u8 mask) {
     return (regval & mask);
 }
 
-static void set_macphy_register(struct oa_tc6* tc6) {
+static int write_macphy_config(struct oa_tc6* tc6, u16 cfgparam1, u16 cfgparam2) {
+    const struct oa_tc6_reg_seq seq[] = {
+        {LAN8650_REG_MMS4_A_00D0, MMS4_A_00D0_V},  {LAN8650_REG_MMS4_A_00E0, MMS4_A_00E0_V},
+        {LAN8650_REG_MMS4_A_0084, cfgparam1},      {LAN8650_REG_MMS4_A_008A, cfgparam2},
+        {LAN8650_REG_MMS4_A_00E9, MMS4_A_00E9_V},  {LAN8650_REG_MMS4_A_00F5, MMS4_A_00F5_V},
+        {LAN8650_REG_MMS4_A_00F4, MMS4_A_00F4_V},  {LAN8650_REG_MMS4_A_00F8, MMS4_A_00F8_V},
+        {LAN8650_REG_MMS4_A_00F9, MMS4_A_00F9_V},  {LAN8650_REG_MMS4_SLPCTL1, MMS4_A_0081_V},
+        {LAN8650_REG_MMS4_A_0091, MMS4_A_0091_V},  {LAN8650_REG_MMS4_A_0077, MMS4_A_0077_V},
+        {LAN8650_REG_MMS4_TXMMSKH, MMS4_A_0043_V}, {LAN8650_REG_MMS4_TXMMSKL, MMS4_A_0044_V},
+        {LAN8650_REG_MMS4_TXMLOC, MMS4_A_0045_V},  {LAN8650_REG_MMS4_RXMMSKH, MMS4_A_0053_V},
+        {LAN8650_REG_MMS4_RXMMSKL, MMS4_A_0054_V}, {LAN8650_REG_MMS4_RXMLOC, MMS4_A_0055_V},
+        {LAN8650_REG_MMS4_TXMCTL, MMS4_A_0040_V},  {LAN8650_REG_MMS4_RXMCTL, MMS4_A_0050_V},
+    };
+
+    /* The consecutive TXM and RXM registers go out as bursts, everything in
+     * a single SPI message.
+     */
+    return oa_tc6_write_register_seq(tc6, seq, ARRAY_SIZE(seq));
+}
+
+static int set_macphy_register(struct oa_tc6* tc6) {
     u8 value1, value2;
     char offset1, offset2;
     u16 cfgparam1, cfgparam2;
@@ -1405,30 +2845,17 @@ static void set_macphy_register(struct oa_tc6* tc6) {
                 (u16)(((VALUE1_OFFSET2 + offset1) & VALUE_OFFSET_MASK) << VALUE1_SHIFT2) | VALUE1_LOWEST_VAL;
     cfgparam2 = (u16)(((VALUE2_OFFSET + offset2) & VALUE_OFFSET_MASK) << VALUE2_SHIFT);
 
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00D0, MMS4_A_00D0_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00E0, MMS4_A_00E0_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_0084, cfgparam1);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_008A, cfgparam2);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00E9, MMS4_A_00E9_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00F5, MMS4_A_00F5_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00F4, MMS4_A_00F4_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00F8, MMS4_A_00F8_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_00F9, MMS4_A_00F9_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_SLPCTL1, MMS4_A_0081_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_0091, MMS4_A_0091_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_A_0077, MMS4_A_0077_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_TXMMSKH, MMS4_A_0043_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_TXMMSKL, MMS4_A_0044_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_TXMLOC, MMS4_A_0045_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_RXMMSKH, MMS4_A_0053_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_RXMMSKL, MMS4_A_0054_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_RXMLOC, MMS4_A_0055_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_TXMCTL, MMS4_A_0040_V);
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_RXMCTL, MMS4_A_0050_V);
+    return write_macphy_config(tc6, cfgparam1, cfgparam2);
 }
 
 int init_lan865x(struct oa_tc6* tc6);
 int init_lan865x(struct oa_tc6* tc6) {
+    static const struct oa_tc6_reg_seq init_seq[] = {
+        {LAN8650_REG_MMS4_PLCA_CTRL0, MMS4_PLCA_CTRL0_INIT_VAL}, /* Enable PLCA */
+        {LAN8650_REG_MMS1_MAC_NCFGR, MMS1_MAC_NCFGR_INIT_VAL},   /* Enable unicast, multicast */
+        {LAN8650_REG_MMS1_MAC_NCR, MMS1_MAC_NCR_INIT_VAL},       /* Enable MACPHY TX, RX */
+        {LAN8650_REG_MMS1_MAC_TI, TIMER_INCREMENT},              /* Time stamping timer increment */
+    };
     u32 regval;
     int ret;
 
@@ -1454,22 +2881,23 @@ int init_lan865x(struct oa_tc6* tc6) {
     if (ret)
         return ret;
 
-    set_macphy_register(tc6);
-
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS4_PLCA_CTRL0, MMS4_PLCA_CTRL0_INIT_VAL); /* Enable PLCA */
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS1_MAC_NCFGR, MMS1_MAC_NCFGR_INIT_VAL);   /* Enable unicast, multicast */
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS1_MAC_NCR, MMS1_MAC_NCR_INIT_VAL);       /* Enable MACPHY TX, RX */
+    ret = set_macphy_register(tc6);
+    if (ret)
+        return ret;
 
-    oa_tc6_write_register(tc6, LAN8650_REG_MMS1_MAC_TI, TIMER_INCREMENT); /* Enable MACPHY TX, RX */
+    ret = oa_tc6_write_register_seq(tc6, init_seq, ARRAY_SIZE(init_seq));
+    if (ret)
+        return ret;
 
     /* Read OA_CONFIG0 */
     oa_tc6_read_register(tc6, LAN8650_REG_MMS0_OA_CONFIG0, &regval);
     /* Set SYNC bit of OA_CONFIG0 */
     regval |= MMS0_OA_CONFIG0_SYNC_SHIFT;
-    /* Set FTSE Frame Timestamp Enable bit of OA_CONFIG0 */
-    regval |= MMS0_OA_CONFIG0_FTSE_SHIFT;
-    /* Set FTSS Frame Timestamp Select bit of OA_CONFIG0 */
-    regval |= MMS0_OA_CONFIG0_FTSS_SHIFT;
+    /* FTSE is set by oa_tc6_set_rx_timestamp() once rx timestamps are wanted.
+     * Set FTSS Frame Timestamp Select bit of OA_CONFIG0 for 64-bit timestamps.
+     */
+    if (!rx_timestamp_32bit)
+        regval |= MMS0_OA_CONFIG0_FTSS_SHIFT;
     oa_tc6_write_register(tc6, LAN8650_REG_MMS0_OA_CONFIG0, regval);
 
     /* Read OA_STATUS0 */
@@ -1492,6 +2920,7 @@ int init_lan865x(struct oa_tc6* tc6) {
  * initialization is successful otherwise NULL.
  */
 struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
+    struct regmap_config regmap_config;
     struct oa_tc6* tc6;
     int ret;
 
@@ -1502,8 +2931,10 @@ struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
     tc6->spi = spi;
     tc6->netdev = netdev;
     SET_NETDEV_DEV(netdev, &spi->dev);
+    tc6->chunk_payload_size = oa_tc6_get_chunk_payload_size(tc6);
+    tc6->chunk_size = OA_TC6_DATA_HEADER_SIZE + tc6->chunk_payload_size;
     mutex_init(&tc6->spi_ctrl_lock);
-    spin_lock_init(&tc6->tx_skb_lock);
+    spin_lock_init(&tc6->ts_capture_lock);
 
     /* Set the SPI controller to pump at realtime priority */
     tc6->spi->rt = true;
@@ -1517,14 +2948,79 @@ struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
     if (!tc6->spi_ctrl_rx_buf)
         return NULL;
 
-    tc6->spi_data_tx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE, GFP_KERNEL);
+    tc6->spi_data_tx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE(tc6), GFP_KERNEL);
     if (!tc6->spi_data_tx_buf)
         return NULL;
 
-    tc6->spi_data_rx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE, GFP_KERNEL);
+    tc6->spi_data_rx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_SPI_DATA_BUF_SIZE(tc6), GFP_KERNEL);
     if (!tc6->spi_data_rx_buf)
         return NULL;
 
+    tc6->ctrl_batch_tx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_CTRL_BATCH_BUF_SIZE, GFP_KERNEL);
+    if (!tc6->ctrl_batch_tx_buf)
+        return NULL;
+
+    tc6->ctrl_batch_rx_buf = devm_kzalloc(&tc6->spi->dev, OA_TC6_CTRL_BATCH_BUF_SIZE, GFP_KERNEL);
+    if (!tc6->ctrl_batch_rx_buf)
+        return NULL;
+
+    tc6->ctrl_batch_xfers =
+        devm_kcalloc(&tc6->spi->dev, OA_TC6_CTRL_BATCH_MAX_XFERS, sizeof(*tc6->ctrl_batch_xfers), GFP_KERNEL);
+    if (!tc6->ctrl_batch_xfers)
+        return NULL;
+
+    tc6->tx_ring = devm_kcalloc(&tc6->spi->dev, OA_TC6_TX_RING_MAX_SIZE, sizeof(*tc6->tx_ring), GFP_KERNEL);
+    if (!tc6->tx_ring)
+        return NULL;
+
+    tc6->tx_ring_size = OA_TC6_TX_RING_DEFAULT_SIZE;
+
+    regmap_config = oa_tc6_regmap_config;
+    regmap_config.lock_arg = tc6;
+    tc6->regmap = devm_regmap_init(&tc6->spi->dev, &oa_tc6_regmap_bus, tc6, &regmap_config);
+    if (IS_ERR(tc6->regmap)) {
+        dev_err(&tc6->spi->dev, "Failed to create regmap: %ld\n", PTR_ERR(tc6->regmap));
+        return NULL;
+    }
+
+    /* SPI data transfers are split into several spi_transfers when tx skb
+     * data or rx pool pages are used in place.
+     */
+    if (tx_sg || rx_page_pool) {
+        tc6->spi_tx_segs = devm_kcalloc(&tc6->spi->dev, OA_TC6_MAX_SPI_TX_SEGS, sizeof(*tc6->spi_tx_segs), GFP_KERNEL);
+        if (!tc6->spi_tx_segs)
+            return NULL;
+
+        tc6->spi_rx_segs = devm_kcalloc(&tc6->spi->dev, OA_TC6_MAX_SPI_RX_SEGS, sizeof(*tc6->spi_rx_segs), GFP_KERNEL);
+        if (!tc6->spi_rx_segs)
+            return NULL;
+
+        tc6->spi_data_xfers = devm_kcalloc(&tc6->spi->dev, OA_TC6_MAX_SPI_TX_SEGS + OA_TC6_MAX_SPI_RX_SEGS,
+                                           sizeof(*tc6->spi_data_xfers), GFP_KERNEL);
+        if (!tc6->spi_data_xfers)
+            return NULL;
+    }
+
+    skb_queue_head_init(&tc6->tx_done_q);
+    if (tx_sg) {
+        tc6->tx_sg = true;
+        netdev->hw_features |= NETIF_F_SG;
+        netdev->features |= NETIF_F_SG;
+    }
+
+    /* The tx segments and rx pool page slots are kept for a single
+     * transfer in flight only.
+     */
+    if (spi_pipeline && (tx_sg || rx_page_pool)) {
+        dev_warn(&tc6->spi->dev, "spi_pipeline is not supported with tx_sg or rx_page_pool, ignored\n");
+    } else if (spi_pipeline) {
+        ret = oa_tc6_spi_pipeline_init(tc6);
+        if (ret) {
+            dev_err(&tc6->spi->dev, "Failed to allocate SPI pipeline buffers: %d\n", ret);
+            return NULL;
+        }
+    }
+
     ret = oa_tc6_sw_reset_macphy(tc6);
     if (ret) {
         dev_err(&tc6->spi->dev, "MAC-PHY software reset failed: %d\n", ret);
@@ -1543,6 +3039,12 @@ struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
         return NULL;
     }
 
+    ret = oa_tc6_set_chunk_payload_size(tc6);
+    if (ret) {
+        dev_err(&tc6->spi->dev, "Failed to set the chunk payload size: %d\n", ret);
+        goto phy_exit;
+    }
+
     ret = init_lan865x(tc6);
     if (ret) {
         dev_err(&tc6->spi->dev, "Failed to init_lan865x: %d\n", ret);
@@ -1563,10 +3065,28 @@ struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
 
     init_waitqueue_head(&tc6->spi_wq);
 
+    ret = oa_tc6_spi_msgs_init(tc6);
+    if (ret) {
+        dev_err(&tc6->spi->dev, "Failed to prepare SPI messages: %d\n", ret);
+        goto phy_exit;
+    }
+
+    if (rx_page_pool) {
+        ret = oa_tc6_rx_page_pool_init(tc6);
+        if (ret) {
+            dev_err(&tc6->spi->dev, "Failed to create rx page pool: %d\n", ret);
+            goto spi_msgs_exit;
+        }
+    }
+
+    skb_queue_head_init(&tc6->rx_skb_q);
+    netif_napi_add_weight(tc6->netdev, &tc6->napi, oa_tc6_napi_poll, clamp(rx_napi_weight, 1, NAPI_POLL_WEIGHT));
+    napi_enable(&tc6->napi);
+
     tc6->spi_thread = kthread_run(oa_tc6_spi_thread_handler, tc6, "oa-tc6-spi-thread");
     if (IS_ERR(tc6->spi_thread)) {
         dev_err(&tc6->spi->dev, "Failed to create SPI thread\n");
-        goto phy_exit;
+        goto napi_del;
     }
 
     sched_set_fifo(tc6->spi_thread);
@@ -1587,10 +3107,19 @@ struct oa_tc6* oa_tc6_init(struct spi_device* spi, struct net_device* netdev) {
     tc6->int_flag = true;
     wake_up_interruptible(&tc6->spi_wq);
 
+    oa_tc6_debugfs_init(tc6);
+
     return tc6;
 
 kthread_stop:
     kthread_stop(tc6->spi_thread);
+napi_del:
+    napi_disable(&tc6->napi);
+    netif_napi_del(&tc6->napi);
+    skb_queue_purge(&tc6->rx_skb_q);
+    oa_tc6_rx_page_pool_exit(tc6);
+spi_msgs_exit:
+    oa_tc6_spi_msgs_exit(tc6);
 phy_exit:
     oa_tc6_phy_exit(tc6);
     return NULL;
@@ -1602,11 +3131,20 @@ EXPORT_SYMBOL_GPL(oa_tc6_init);
  * @tc6: oa_tc6 struct.
  */
 void oa_tc6_exit(struct oa_tc6* tc6) {
+    debugfs_remove_recursive(tc6->debugfs_dir);
     oa_tc6_phy_exit(tc6);
     kthread_stop(tc6->spi_thread);
+    napi_disable(&tc6->napi);
+    netif_napi_del(&tc6->napi);
+    skb_queue_purge(&tc6->rx_skb_q);
     dev_kfree_skb_any(tc6->ongoing_tx_skb);
-    dev_kfree_skb_any(tc6->waiting_tx_skb);
+    tc6->ongoing_tx_skb = NULL;
+    oa_tc6_tx_ring_purge(tc6);
+    __skb_queue_purge(&tc6->tx_done_q);
     dev_kfree_skb_any(tc6->rx_skb);
+    tc6->rx_skb = NULL;
+    oa_tc6_rx_page_pool_exit(tc6);
+    oa_tc6_spi_msgs_exit(tc6);
 }
 EXPORT_SYMBOL_GPL(oa_tc6_exit);
 
@@ -12,11 +12,24 @@
 
 struct oa_tc6;
 
+struct oa_tc6_reg_seq {
+	u32 address;
+	u32 value;
+};
+
+typedef void (*oa_tc6_ts_capture_handler_t)(void *ctx, u32 ttsc_status,
+					    u32 ttsc_missed);
+
 struct oa_tc6 *oa_tc6_init(struct spi_device *spi, struct net_device *netdev);
 void oa_tc6_exit(struct oa_tc6 *tc6);
 int oa_tc6_write_register(struct oa_tc6 *tc6, u32 address, u32 value);
 int oa_tc6_write_registers(struct oa_tc6 *tc6, u32 address, u32 value[],
 			   u8 length);
+int oa_tc6_write_register_seq(struct oa_tc6 *tc6,
+			      const struct oa_tc6_reg_seq seq[], int count);
+int oa_tc6_register_ts_capture_handler(struct oa_tc6 *tc6,
+				       oa_tc6_ts_capture_handler_t handler,
+				       void *ctx);
 int oa_tc6_read_register(struct oa_tc6 *tc6, u32 address, u32 *value);
 int oa_tc6_read_registers(struct oa_tc6 *tc6, u32 address, u32 value[],
 			  u8 length);
@@ -27,3 +40,12 @@ netdev_tx_t oa_tc6_start_xmit(struct oa_tc6 *tc6, struct sk_buff *skb, u8 ts_cap
 netdev_tx_t oa_tc6_start_xmit(struct oa_tc6 *tc6, struct sk_buff *skb);
 #endif /* FRAME_TIMESTAMP_ENABLE */
 int oa_tc6_zero_align_receive_frame_enable(struct oa_tc6 *tc6);
+int oa_tc6_set_cut_through(struct oa_tc6 *tc6, bool tx, bool rx);
+#ifdef FRAME_TIMESTAMP_ENABLE
+int oa_tc6_set_rx_timestamp(struct oa_tc6 *tc6, bool enable);
+void oa_tc6_set_rx_ts_filter(struct oa_tc6 *tc6, int rx_filter);
+void oa_tc6_set_rx_ts_reference(struct oa_tc6 *tc6, u64 phc_ns);
+#endif /* FRAME_TIMESTAMP_ENABLE */
+void oa_tc6_get_tx_ring_param(struct oa_tc6 *tc6, u32 *size, u32 *max_size);
+int oa_tc6_set_tx_ring_size(struct oa_tc6 *tc6, u32 size);
+u32 oa_tc6_get_tx_backlog(struct oa_tc6 *tc6);
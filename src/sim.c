@@ -0,0 +1,723 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <10baset1s/rpi_spi.h>
+#include <10baset1s/sim.h>
+#include <10baset1s/xbaset1s_arch.h>
+
+/* Behavioral model of the LAN8650 OA-TC6 SPI protocol. Control transactions
+ * access a register file, data transactions move frames between the chunk
+ * FIFOs and a multidrop segment made of unix datagram sockets.
+ */
+
+#define SIM_MAX_HANDLES 4
+
+/* Bytes clocked with chip select asserted at most, enough for a burst of 48 chunks */
+#define SIM_MAX_TRANSACTION_SIZE 4096
+
+#define CHUNK_PAYLOAD_SIZE 64
+#define HEADER_SIZE 4
+#define CHUNK_SIZE (HEADER_SIZE + CHUNK_PAYLOAD_SIZE)
+
+/* TX buffer in chunks, the MAC-PHY sends them at the line rate */
+#define SIM_TX_CREDITS 31
+#define SIM_LINE_RATE_BPS 10000000ULL
+#define SIM_CHUNK_WIRE_NS (CHUNK_PAYLOAD_SIZE * 8 * 1000000000ULL / SIM_LINE_RATE_BPS)
+#define SIM_RCA_MAX 31
+#define SIM_RX_QUEUE_FRAMES 64
+#define SIM_FRAME_MAX_SIZE 2048
+#define SIM_TIMESTAMP_SIZE 8
+#define SIM_TIMESTAMP32_SIZE 4
+#define TIMESTAMP32_SECONDS_SHIFT 30
+
+/* A peer in another process gets this long to make room in its socket for a frame */
+#define SIM_SEND_TIMEOUT_MS 10
+
+/* Header bits, control and data */
+#define HDR_DNC (1U << 31)
+#define CTRL_WNR (1U << 29)
+#define CTRL_MMS_SHIFT 24
+#define CTRL_MMS_MASK 0xF
+#define CTRL_ADDR_SHIFT 8
+#define CTRL_ADDR_MASK 0xFFFF
+#define CTRL_LEN_SHIFT 1
+#define CTRL_LEN_MASK 0x7F
+#define DATA_NORX (1U << 29)
+#define DATA_DV (1U << 21)
+#define DATA_SV (1U << 20)
+#define DATA_EV (1U << 14)
+#define DATA_EBO_SHIFT 8
+#define DATA_EBO_MASK 0x3F
+#define DATA_TSC_SHIFT 6
+#define DATA_TSC_MASK 0x3
+
+/* Footer bits */
+#define FTR_EXST (1U << 31)
+#define FTR_HDRB (1U << 30)
+#define FTR_SYNC (1U << 29)
+#define FTR_RCA_SHIFT 24
+#define FTR_DV (1U << 21)
+#define FTR_SV (1U << 20)
+#define FTR_EV (1U << 14)
+#define FTR_EBO_SHIFT 8
+#define FTR_RTSA (1U << 7)
+#define FTR_TXC_SHIFT 1
+
+/* MMS0 registers */
+#define REG_CONFIG0 0x04
+#define CONFIG0_SYNC (1U << 15)
+#define CONFIG0_FTSE (1U << 7)
+#define CONFIG0_FTSS (1U << 6)
+#define CONFIG0_DEFAULT 0x0006
+#define REG_STATUS0 0x08
+#define STATUS0_TXBOE (1U << 1)
+#define STATUS0_RXBOE (1U << 3)
+#define STATUS0_RESETC (1U << 6)
+#define STATUS0_TTSCA_SHIFT 8
+#define REG_BUFSTS 0x0B
+#define REG_IMASK0 0x0C
+#define IMASK0_DEFAULT 0x1FBF
+#define REG_TTSCAH 0x10
+
+/* MMS1 registers */
+#define REG_MAC_TSL 0x74
+#define REG_MAC_TN 0x75
+
+#define SIM_MAX_REGS 256
+
+struct sim_reg {
+    uint8_t mms;
+    uint16_t addr;
+    uint32_t value;
+};
+
+struct sim_frame {
+    uint16_t length;
+    uint64_t timestamp; /* ns, taken when the frame reached the node */
+    uint8_t data[SIM_FRAME_MAX_SIZE];
+};
+
+struct sim_node {
+    int used;
+    int sock;
+    int node_id;
+    char segment[64];
+
+    struct sim_reg regs[SIM_MAX_REGS];
+    int no_of_regs;
+    int64_t clock_offset; /* MAC TSU time - CLOCK_MONOTONIC, ns */
+
+    /* TX frame being assembled from the data chunks */
+    uint8_t tx_frame[SIM_FRAME_MAX_SIZE];
+    uint16_t tx_len;
+    int tx_in_frame;
+    int tx_credits;
+    uint64_t tx_refill_time; /* CLOCK_MONOTONIC, ns, when the chunk on the wire started */
+
+    /* RX FIFO, rx_offset counts the bytes of the head frame already sent */
+    struct sim_frame rx_q[SIM_RX_QUEUE_FRAMES];
+    int rx_head;
+    int rx_count;
+    uint16_t rx_offset;
+
+    uint32_t dropped_frames; /* Sent frames a peer in another process didn't take in time */
+};
+
+static struct sim_node nodes[SIM_MAX_HANDLES];
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t sim_clock(struct sim_node* node) {
+    return monotonic_ns() + (uint64_t)node->clock_offset;
+}
+
+static uint32_t get_parity(uint32_t p) {
+    p ^= p >> 1;
+    p ^= p >> 2;
+    p = (p & 0x11111111U) * 0x11111111U;
+
+    /* Odd parity is used here */
+    return !((p >> 28) & 1);
+}
+
+static int parity_ok(uint32_t header) {
+    return get_parity(header & ~1U) == (header & 1U);
+}
+
+static void put_be32(uint8_t* buf, uint32_t val) {
+    buf[0] = (uint8_t)(val >> 24);
+    buf[1] = (uint8_t)(val >> 16);
+    buf[2] = (uint8_t)(val >> 8);
+    buf[3] = (uint8_t)val;
+}
+
+static uint32_t get_be32(const uint8_t* buf) {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+static uint32_t* find_reg(struct sim_node* node, uint8_t mms, uint16_t addr, int create) {
+    for (int i = 0; i < node->no_of_regs; i++) {
+        if (node->regs[i].mms == mms && node->regs[i].addr == addr) {
+            return &node->regs[i].value;
+        }
+    }
+
+    if (!create || node->no_of_regs == SIM_MAX_REGS) {
+        return NULL;
+    }
+
+    node->regs[node->no_of_regs].mms = mms;
+    node->regs[node->no_of_regs].addr = addr;
+    node->regs[node->no_of_regs].value = 0;
+
+    return &node->regs[node->no_of_regs++].value;
+}
+
+static uint32_t get_reg(struct sim_node* node, uint8_t mms, uint16_t addr) {
+    uint32_t* reg = find_reg(node, mms, addr, 0);
+
+    return reg ? *reg : 0;
+}
+
+static void set_reg(struct sim_node* node, uint8_t mms, uint16_t addr, uint32_t value) {
+    uint32_t* reg = find_reg(node, mms, addr, 1);
+
+    if (reg) {
+        *reg = value;
+    }
+}
+
+static void rx_buffer_overflow(struct sim_node* node) {
+    set_reg(node, 0, REG_STATUS0, get_reg(node, 0, REG_STATUS0) | STATUS0_RXBOE);
+}
+
+/* Moves the frames other nodes have sent into the RX FIFO */
+static void receive_from_segment(struct sim_node* node) {
+    for (;;) {
+        struct sim_frame* frame;
+        ssize_t len;
+
+        if (node->rx_count == SIM_RX_QUEUE_FRAMES) {
+            /* The MAC-PHY drops frames when its buffer is full */
+            uint8_t discard[SIM_FRAME_MAX_SIZE];
+
+            if (recv(node->sock, discard, sizeof(discard), MSG_DONTWAIT) < 0) {
+                return;
+            }
+            rx_buffer_overflow(node);
+            continue;
+        }
+
+        frame = &node->rx_q[(node->rx_head + node->rx_count) % SIM_RX_QUEUE_FRAMES];
+        len = recv(node->sock, frame->data, sizeof(frame->data), MSG_DONTWAIT);
+        if (len <= 0) {
+            return;
+        }
+
+        frame->length = (uint16_t)len;
+        frame->timestamp = sim_clock(node);
+        node->rx_count++;
+    }
+}
+
+/* Bytes of the timestamp in front of a received frame, FTSS selects the 64-bit format */
+static int rx_timestamp_size(struct sim_node* node) {
+    uint32_t config0 = get_reg(node, 0, REG_CONFIG0);
+
+    if (!(config0 & CONFIG0_FTSE)) {
+        return 0;
+    }
+
+    return (config0 & CONFIG0_FTSS) ? SIM_TIMESTAMP_SIZE : SIM_TIMESTAMP32_SIZE;
+}
+
+static int rx_chunks_available(struct sim_node* node) {
+    int ts_size = rx_timestamp_size(node);
+    int chunks = 0;
+
+    for (int i = 0; i < node->rx_count && chunks < SIM_RCA_MAX; i++) {
+        int len = node->rx_q[(node->rx_head + i) % SIM_RX_QUEUE_FRAMES].length + ts_size;
+
+        if (i == 0) {
+            len -= node->rx_offset;
+        }
+        chunks += (len + CHUNK_PAYLOAD_SIZE - 1) / CHUNK_PAYLOAD_SIZE;
+    }
+
+    return chunks < SIM_RCA_MAX ? chunks : SIM_RCA_MAX;
+}
+
+/* Returns the credits for the chunks which have left the TX buffer since the last call */
+static int tx_credits(struct sim_node* node) {
+    uint64_t now = monotonic_ns();
+    uint64_t sent = (now - node->tx_refill_time) / SIM_CHUNK_WIRE_NS;
+
+    if (node->tx_credits + sent >= SIM_TX_CREDITS) {
+        node->tx_credits = SIM_TX_CREDITS;
+        node->tx_refill_time = now;
+    } else {
+        node->tx_credits += (int)sent;
+        node->tx_refill_time += sent * SIM_CHUNK_WIRE_NS;
+    }
+
+    return node->tx_credits;
+}
+
+static uint32_t read_reg(struct sim_node* node, uint8_t mms, uint16_t addr) {
+    uint64_t now;
+
+    if (mms == 0 && addr == REG_BUFSTS) {
+        /* The MAC-PHY receives while the host is idle too */
+        receive_from_segment(node);
+        return ((uint32_t)tx_credits(node) << 8) | (uint32_t)rx_chunks_available(node);
+    }
+    if (mms == 1 && (addr == REG_MAC_TSL || addr == REG_MAC_TN)) {
+        now = sim_clock(node);
+        return addr == REG_MAC_TSL ? (uint32_t)(now / 1000000000ULL) : (uint32_t)(now % 1000000000ULL);
+    }
+
+    return get_reg(node, mms, addr);
+}
+
+static void write_reg(struct sim_node* node, uint8_t mms, uint16_t addr, uint32_t value) {
+    uint64_t now;
+
+    if (mms == 0 && addr == REG_STATUS0) {
+        /* Write 1 to clear */
+        set_reg(node, mms, addr, get_reg(node, mms, addr) & ~value);
+        return;
+    }
+    if (mms == 1 && (addr == REG_MAC_TSL || addr == REG_MAC_TN)) {
+        now = sim_clock(node);
+        if (addr == REG_MAC_TSL) {
+            now = (uint64_t)value * 1000000000ULL + now % 1000000000ULL;
+        } else {
+            now = now / 1000000000ULL * 1000000000ULL + (value & NANOSECONDS_MASK);
+        }
+        node->clock_offset = (int64_t)(now - monotonic_ns());
+        return;
+    }
+
+    set_reg(node, mms, addr, value);
+}
+
+static void reset_node(struct sim_node* node) {
+    node->no_of_regs = 0;
+    node->clock_offset = 0;
+    node->tx_in_frame = 0;
+    node->tx_credits = SIM_TX_CREDITS;
+    node->tx_refill_time = monotonic_ns();
+    node->rx_count = 0;
+    node->rx_offset = 0;
+
+    set_reg(node, 0, REG_CONFIG0, CONFIG0_DEFAULT);
+    set_reg(node, 0, REG_STATUS0, STATUS0_RESETC);
+    set_reg(node, 0, REG_IMASK0, IMASK0_DEFAULT);
+}
+
+static void socket_name(struct sockaddr_un* addr, socklen_t* len, const char* segment, int node_id) {
+    int n;
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    /* Abstract namespace, nothing to clean up in the file system */
+    n = snprintf(&addr->sun_path[1], sizeof(addr->sun_path) - 1, "10baset1s-sim-%s-%d", segment, node_id);
+    *len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + (size_t)n);
+}
+
+static struct sim_node* find_local_node(const char* segment, int node_id) {
+    for (int i = 0; i < SIM_MAX_HANDLES; i++) {
+        if (nodes[i].used && nodes[i].node_id == node_id && !strcmp(nodes[i].segment, segment)) {
+            return &nodes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void receive_local(struct sim_node* node, const uint8_t* data, uint16_t length) {
+    struct sim_frame* frame;
+
+    if (node->rx_count == SIM_RX_QUEUE_FRAMES) {
+        rx_buffer_overflow(node);
+        return;
+    }
+
+    frame = &node->rx_q[(node->rx_head + node->rx_count) % SIM_RX_QUEUE_FRAMES];
+    memcpy(frame->data, data, length);
+    frame->length = length;
+    frame->timestamp = sim_clock(node);
+    node->rx_count++;
+}
+
+static void transmit_to_segment(struct sim_node* node, int ts_reg) {
+    struct sockaddr_un addr;
+    socklen_t addr_len;
+    uint64_t now = sim_clock(node);
+
+    for (int i = 0; i < SIM_MAX_NODES; i++) {
+        struct sim_node* peer;
+
+        if (i == node->node_id) {
+            continue;
+        }
+
+        /* A datagram would wait in the socket queue, which holds a few frames only, until the peer polls */
+        peer = find_local_node(node->segment, i);
+        if (peer) {
+            receive_local(peer, node->tx_frame, node->tx_len);
+            continue;
+        }
+
+        /* Nodes which are not there are fine, it's a shared medium. A full socket blocks for up to
+         * SIM_SEND_TIMEOUT_MS rather than losing the frame. */
+        socket_name(&addr, &addr_len, node->segment, i);
+        if (sendto(node->sock, node->tx_frame, node->tx_len, 0, (struct sockaddr*)&addr, addr_len) < 0 &&
+            (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            node->dropped_frames++;
+        }
+    }
+
+    if (ts_reg) {
+        uint16_t reg = (uint16_t)(REG_TTSCAH + (ts_reg - 1) * 2);
+
+        set_reg(node, 0, reg, (uint32_t)(now / 1000000000ULL));
+        set_reg(node, 0, (uint16_t)(reg + 1), (uint32_t)(now % 1000000000ULL));
+        set_reg(node, 0, REG_STATUS0, get_reg(node, 0, REG_STATUS0) | (1U << (STATUS0_TTSCA_SHIFT + ts_reg - 1)));
+    }
+}
+
+static void process_tx_chunk(struct sim_node* node, uint32_t header, const uint8_t* payload) {
+    int ebo = (int)((header >> DATA_EBO_SHIFT) & DATA_EBO_MASK);
+    int len = (header & DATA_EV) ? ebo + 1 : CHUNK_PAYLOAD_SIZE;
+
+    if (!(header & DATA_DV)) {
+        return;
+    }
+
+    if (!tx_credits(node)) {
+        /* The chunk doesn't fit into the TX buffer, the frame is lost */
+        set_reg(node, 0, REG_STATUS0, get_reg(node, 0, REG_STATUS0) | STATUS0_TXBOE);
+        node->tx_in_frame = 0;
+        return;
+    }
+    node->tx_credits--;
+
+    if (header & DATA_SV) {
+        node->tx_in_frame = 1;
+        node->tx_len = 0;
+    }
+    if (!node->tx_in_frame) {
+        return;
+    }
+
+    if (node->tx_len + len <= SIM_FRAME_MAX_SIZE) {
+        memcpy(&node->tx_frame[node->tx_len], payload, (size_t)len);
+        node->tx_len += (uint16_t)len;
+    }
+
+    if (header & DATA_EV) {
+        transmit_to_segment(node, (int)((header >> DATA_TSC_SHIFT) & DATA_TSC_MASK));
+        node->tx_in_frame = 0;
+    }
+}
+
+static uint32_t produce_rx_chunk(struct sim_node* node, uint8_t* payload) {
+    int ts_size = rx_timestamp_size(node);
+    uint32_t footer = 0;
+    struct sim_frame* frame;
+    int pos = 0;
+    int len;
+
+    memset(payload, 0, CHUNK_PAYLOAD_SIZE);
+    if (!node->rx_count) {
+        return footer;
+    }
+
+    frame = &node->rx_q[node->rx_head];
+    footer |= FTR_DV;
+
+    if (!node->rx_offset) {
+        footer |= FTR_SV;
+        if (ts_size == SIM_TIMESTAMP_SIZE) {
+            put_be32(payload, (uint32_t)(frame->timestamp / 1000000000ULL));
+            put_be32(payload + 4, (uint32_t)(frame->timestamp % 1000000000ULL));
+        } else if (ts_size == SIM_TIMESTAMP32_SIZE) {
+            /* The 2 LSBs of the seconds and the nanoseconds */
+            put_be32(payload, (uint32_t)(frame->timestamp / 1000000000ULL) << TIMESTAMP32_SECONDS_SHIFT |
+                                  (uint32_t)(frame->timestamp % 1000000000ULL));
+        }
+        if (ts_size) {
+            footer |= FTR_RTSA;
+            pos = ts_size;
+        }
+    }
+
+    len = frame->length - node->rx_offset;
+    if (len > CHUNK_PAYLOAD_SIZE - pos) {
+        len = CHUNK_PAYLOAD_SIZE - pos;
+    }
+    memcpy(payload + pos, &frame->data[node->rx_offset], (size_t)len);
+    node->rx_offset += (uint16_t)len;
+
+    if (node->rx_offset == frame->length) {
+        footer |= FTR_EV | ((uint32_t)(pos + len - 1) << FTR_EBO_SHIFT);
+        node->rx_head = (node->rx_head + 1) % SIM_RX_QUEUE_FRAMES;
+        node->rx_count--;
+        node->rx_offset = 0;
+    }
+
+    return footer;
+}
+
+static uint32_t finish_footer(struct sim_node* node, uint32_t footer, int header_bad) {
+    uint32_t status = get_reg(node, 0, REG_STATUS0);
+    uint32_t mask = get_reg(node, 0, REG_IMASK0);
+
+    if (status & ~mask) {
+        footer |= FTR_EXST;
+    }
+    if (header_bad) {
+        footer |= FTR_HDRB;
+    }
+    if (get_reg(node, 0, REG_CONFIG0) & CONFIG0_SYNC) {
+        footer |= FTR_SYNC;
+    }
+    receive_from_segment(node);
+    footer |= (uint32_t)rx_chunks_available(node) << FTR_RCA_SHIFT;
+    footer |= (uint32_t)tx_credits(node) << FTR_TXC_SHIFT;
+
+    return footer | get_parity(footer);
+}
+
+static int data_transfer(struct sim_node* node, uint8_t* rx, const uint8_t* tx, uint16_t count) {
+    if (count % CHUNK_SIZE) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    receive_from_segment(node);
+
+    for (int i = 0; i < count / CHUNK_SIZE; i++) {
+        const uint8_t* tx_chunk = tx + i * CHUNK_SIZE;
+        uint8_t* rx_chunk = rx + i * CHUNK_SIZE;
+        uint32_t header = get_be32(tx_chunk);
+        int header_bad = !parity_ok(header);
+        uint32_t footer = 0;
+
+        if (!header_bad) {
+            process_tx_chunk(node, header, tx_chunk + HEADER_SIZE);
+        }
+
+        if (!header_bad && !(header & DATA_NORX)) {
+            footer = produce_rx_chunk(node, rx_chunk);
+        } else {
+            memset(rx_chunk, 0, CHUNK_PAYLOAD_SIZE);
+        }
+
+        put_be32(rx_chunk + CHUNK_PAYLOAD_SIZE, finish_footer(node, footer, header_bad));
+    }
+
+    return count;
+}
+
+/* TX: header, values, 4 ignored bytes. RX: 4 ignored bytes, echoed header, values. */
+static int ctrl_transfer(struct sim_node* node, uint8_t* rx, const uint8_t* tx, uint16_t count) {
+    uint32_t header = get_be32(tx);
+    uint8_t mms = (uint8_t)((header >> CTRL_MMS_SHIFT) & CTRL_MMS_MASK);
+    uint16_t addr = (uint16_t)((header >> CTRL_ADDR_SHIFT) & CTRL_ADDR_MASK);
+    int length = (int)((header >> CTRL_LEN_SHIFT) & CTRL_LEN_MASK) + 1;
+
+    if (count < (length + 2) * 4) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    memset(rx, 0, count);
+    if (!parity_ok(header)) {
+        /* A bad header is not echoed */
+        return count;
+    }
+
+    put_be32(rx + 4, header);
+    for (int i = 0; i < length; i++) {
+        uint16_t reg = (uint16_t)(addr + i);
+
+        if (header & CTRL_WNR) {
+            uint32_t value = get_be32(tx + 4 + i * 4);
+
+            write_reg(node, mms, reg, value);
+            put_be32(rx + 8 + i * 4, value);
+        } else {
+            put_be32(rx + 8 + i * 4, read_reg(node, mms, reg));
+        }
+    }
+
+    return count;
+}
+
+int sim_open(const char* segment, int node_id) {
+    struct timeval timeout = {.tv_sec = 0, .tv_usec = SIM_SEND_TIMEOUT_MS * 1000};
+    struct sim_node* node = NULL;
+    struct sockaddr_un addr;
+    socklen_t addr_len;
+    int handle;
+
+    if (!segment || node_id < 0 || node_id >= SIM_MAX_NODES) {
+        return ERR_UNKNOWN_PARAMETER;
+    }
+
+    for (handle = 0; handle < SIM_MAX_HANDLES; handle++) {
+        if (!nodes[handle].used) {
+            node = &nodes[handle];
+            break;
+        }
+    }
+    if (!node) {
+        return ERR_SPI_OPEN_FAILED;
+    }
+
+    memset(node, 0, sizeof(*node));
+    node->sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (node->sock < 0) {
+        return ERR_SPI_OPEN_FAILED;
+    }
+
+    node->node_id = node_id;
+    snprintf(node->segment, sizeof(node->segment), "%s", segment);
+    socket_name(&addr, &addr_len, node->segment, node_id);
+    if (bind(node->sock, (struct sockaddr*)&addr, addr_len) < 0 ||
+        setsockopt(node->sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0) {
+        close(node->sock);
+        return ERR_SPI_OPEN_FAILED;
+    }
+
+    reset_node(node);
+    node->used = 1;
+
+    return handle;
+}
+
+int sim_dropped_frames(unsigned int handle) {
+    if (handle >= SIM_MAX_HANDLES || !nodes[handle].used) {
+        return ERR_BAD_HANDLE;
+    }
+
+    return (int)nodes[handle].dropped_frames;
+}
+
+int spi_open(void) {
+    const char* segment = getenv(SIM_SEGMENT_ENV);
+    const char* node_id = getenv(SIM_NODE_ID_ENV);
+
+    return sim_open(segment ? segment : SIM_DEFAULT_SEGMENT, node_id ? atoi(node_id) : 0);
+}
+
+int spi_open_device(const char* path, uint32_t speed_hz) {
+    const char* node_id = getenv(SIM_NODE_ID_ENV);
+
+    if (!speed_hz || speed_hz > SPI_MAX_SPEED_HZ) {
+        return ERR_BAD_SPI_SPEED;
+    }
+
+    /* There is no device, the path names the segment */
+    return sim_open(path, node_id ? atoi(node_id) : 0);
+}
+
+/* One chip select assertion */
+static int transaction(struct sim_node* node, uint8_t* rxbuffer, const uint8_t* txbuffer, uint16_t count) {
+    if (count < HEADER_SIZE) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    if (get_be32(txbuffer) & HDR_DNC) {
+        return data_transfer(node, rxbuffer, txbuffer, count);
+    }
+
+    return ctrl_transfer(node, rxbuffer, txbuffer, count);
+}
+
+int spi_transfer(unsigned int handle, uint8_t* rxbuffer, uint8_t* txbuffer, uint16_t count) {
+    if (handle >= SIM_MAX_HANDLES || !nodes[handle].used) {
+        return ERR_BAD_HANDLE;
+    }
+    if (!txbuffer || !rxbuffer) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    return transaction(&nodes[handle], rxbuffer, txbuffer, count);
+}
+
+int spi_transfer_vec(unsigned int handle, struct spi_xfer* xfers, int count) {
+    static uint8_t tx[SIM_MAX_TRANSACTION_SIZE];
+    static uint8_t rx[SIM_MAX_TRANSACTION_SIZE];
+    uint16_t len = 0;
+    int first = 0;
+    int total = 0;
+    int ret;
+
+    if (handle >= SIM_MAX_HANDLES || !nodes[handle].used) {
+        return ERR_BAD_HANDLE;
+    }
+    if (count <= 0) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    /* Transfers without cs_change in between make up one transaction */
+    for (int i = 0; i < count; i++) {
+        if (len + xfers[i].count > SIM_MAX_TRANSACTION_SIZE) {
+            return ERR_BAD_SPI_COUNT;
+        }
+        if (xfers[i].txbuffer) {
+            memcpy(&tx[len], xfers[i].txbuffer, xfers[i].count);
+        } else {
+            memset(&tx[len], 0, xfers[i].count);
+        }
+        len += xfers[i].count;
+
+        if (!xfers[i].cs_change && i != count - 1) {
+            continue;
+        }
+
+        ret = transaction(&nodes[handle], rx, tx, len);
+        if (ret < 0) {
+            return ret;
+        }
+
+        len = 0;
+        for (; first <= i; first++) {
+            if (xfers[first].rxbuffer) {
+                memcpy(xfers[first].rxbuffer, &rx[len], xfers[first].count);
+            }
+            len += xfers[first].count;
+        }
+        total += len;
+        len = 0;
+    }
+
+    return total;
+}
+
+int spi_close(unsigned int handle) {
+    if (handle >= SIM_MAX_HANDLES || !nodes[handle].used) {
+        return ERR_BAD_HANDLE;
+    }
+
+    close(nodes[handle].sock);
+    nodes[handle].used = 0;
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <10baset1s/rpi_spi.h>
+#include <10baset1s/xbaset1s_arch.h>
+#include <linux/spi/spidev.h>
+
+#ifndef SPIDEV_DEVICE
+#define SPIDEV_DEVICE "/dev/spidev0.0"
+#endif
+
+#ifndef SPI_SPEED_HZ
+#define SPI_SPEED_HZ SPI_MAX_SPEED_HZ
+#endif
+
+#define SPI_BITS_PER_WORD 8
+
+/* Transfers submitted with one SPI_IOC_MESSAGE at most, as limited by spidev */
+#define SPI_MAX_XFERS 64
+
+/* Handles are the spidev file descriptors */
+#define SPI_MAX_HANDLES 64
+
+static uint32_t spi_speed_hz[SPI_MAX_HANDLES];
+
+int spi_open_device(const char* path, uint32_t speed_hz) {
+    uint8_t mode = SPI_MODE_0;
+    uint8_t bits = SPI_BITS_PER_WORD;
+    int fd;
+
+    if (!speed_hz || speed_hz > SPI_MAX_SPEED_HZ) {
+        return ERR_BAD_SPI_SPEED;
+    }
+
+    fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return ERR_SPI_OPEN_FAILED;
+    }
+
+    if (fd >= SPI_MAX_HANDLES || ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 || ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+        close(fd);
+        return ERR_SPI_OPEN_FAILED;
+    }
+
+    spi_speed_hz[fd] = speed_hz;
+
+    return fd;
+}
+
+int spi_open(void) {
+    return spi_open_device(SPIDEV_DEVICE, SPI_SPEED_HZ);
+}
+
+int spi_transfer_vec(unsigned int handle, struct spi_xfer* xfers, int count) {
+    struct spi_ioc_transfer tr[SPI_MAX_XFERS];
+    int ret;
+
+    if (handle >= SPI_MAX_HANDLES || !spi_speed_hz[handle]) {
+        return ERR_BAD_HANDLE;
+    }
+    if (count <= 0 || count > SPI_MAX_XFERS) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    memset(tr, 0, sizeof(tr[0]) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        tr[i].tx_buf = (uint64_t)(uintptr_t)xfers[i].txbuffer;
+        tr[i].rx_buf = (uint64_t)(uintptr_t)xfers[i].rxbuffer;
+        tr[i].len = xfers[i].count;
+        tr[i].speed_hz = spi_speed_hz[handle];
+        tr[i].bits_per_word = SPI_BITS_PER_WORD;
+        tr[i].cs_change = xfers[i].cs_change;
+    }
+    /* On the last transfer spidev reads cs_change as "keep chip select asserted after the message" */
+    tr[count - 1].cs_change = 0;
+
+    ret = ioctl((int)handle, SPI_IOC_MESSAGE(count), tr);
+    if (ret < 0) {
+        return ERR_SPI_XFER_FAILED;
+    }
+
+    return ret;
+}
+
+int spi_transfer(unsigned int handle, uint8_t* rxbuffer, uint8_t* txbuffer, uint16_t count) {
+    struct spi_xfer xfer = {
+        .rxbuffer = rxbuffer,
+        .txbuffer = txbuffer,
+        .count = count,
+        .cs_change = 0,
+    };
+
+    if (!count) {
+        return ERR_BAD_SPI_COUNT;
+    }
+
+    return spi_transfer_vec(handle, &xfer, 1);
+}
+
+int spi_close(unsigned int handle) {
+    if (handle >= SPI_MAX_HANDLES || !spi_speed_hz[handle]) {
+        return ERR_BAD_HANDLE;
+    }
+
+    spi_speed_hz[handle] = 0;
+
+    return close((int)handle) ? ERR_BAD_HANDLE : 0;
+}